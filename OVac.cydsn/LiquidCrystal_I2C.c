@@ -1,4 +1,7 @@
 #include "LiquidCrystal_I2C.h"
+#if CY_PSOC5
+#include "i2c_queue.h"
+#endif
 
 
 //#include "LiquidCrystal_I2C.h"/Portado para PSoC por Šarūnas Straigis
@@ -48,65 +51,89 @@ void LiquidCrystal_I2C_init(uint8_t lcd_addr, uint8_t lcd_cols, uint8_t lcd_rows
 }
 
 void begin(void){
-  
-	_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+	uint16_t wait;
+	uint8_t step = 0;
 
-	if (_rows > 1) {
-		_displayfunction |= LCD_2LINE;
+	while ((wait = beginStep(step++)) != LCD_BEGIN_DONE) {
+		CyDelay(wait);
 	}
+    
+    return;
+}
 
-	// for some 1 line displays you can select a 10 pixel high font
-	if ((_charsize != 0) && (_rows == 1)) {
-		_displayfunction |= LCD_5x10DOTS;
-	}
+// begin() one step at a time, for callers that have other work to do during the waits.
+// Returns the milliseconds to wait before calling with the next step, or LCD_BEGIN_DONE.
+uint16_t beginStep(uint8_t step){
+	
+	switch (step) {
+	case 0:
+		_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+
+		if (_rows > 1) {
+			_displayfunction |= LCD_2LINE;
+		}
+
+		// for some 1 line displays you can select a 10 pixel high font
+		if ((_charsize != 0) && (_rows == 1)) {
+			_displayfunction |= LCD_5x10DOTS;
+		}
 
-	// SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
-	// according to datasheet, we need at least 40ms after power rises above 2.7V
-	// before sending commands. Arduino can turn on way befer 4.5V so we'll wait 50
-	CyDelay(50); 
+		// SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
+		// according to datasheet, we need at least 40ms after power rises above 2.7V
+		// before sending commands. Arduino can turn on way befer 4.5V so we'll wait 50
+		return 50;
 
-	// Now we pull both RS and R/W low to begin commands
-	expanderWrite(_backlightval);	// reset expanderand turn backlight off (Bit 8 =1)
-	CyDelay(1000);
+	case 1:
+		// Now we pull both RS and R/W low to begin commands
+		expanderWrite(_backlightval);	// reset expanderand turn backlight off (Bit 8 =1)
+		return 1;						// Arduino waits 1000 here, the HD44780 needs none
 
 	//put the LCD into 4 bit mode
 	// this is according to the hitachi HD44780 datasheet
 	// figure 24, pg 46
-
-	// we start in 8bit mode, try to set 4 bit mode
-	write4bits(0x03 << 4);
-	CyDelayUs(4500); // wait min 4.1ms
-
-	// second try
-	write4bits(0x03 << 4);
-	CyDelayUs(4500); // wait min 4.1ms
-
-	// third go!
-	write4bits(0x03 << 4); 
-	CyDelayUs(150);
-
-	// finally, set to 4-bit interface
-	write4bits(0x02 << 4); 
-
-	// set # lines, font size, etc.
-	command(LCD_FUNCTIONSET | _displayfunction);  
-	
-	// turn the display on with no cursor or blinking default
-	_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-	display();
-	
-	// clear it off
-	clear();
-	
-	// Initialize to default text direction (for roman languages)
-	_displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-	
-	// set the entry mode
-	command(LCD_ENTRYMODESET | _displaymode);
-	
-	home();
-    
-    return;
+	case 2:
+		// we start in 8bit mode, try to set 4 bit mode
+		write4bits(0x03 << 4);
+		return 5; // wait min 4.1ms
+
+	case 3:
+		// second try
+		write4bits(0x03 << 4);
+		return 5; // wait min 4.1ms
+
+	case 4:
+		// third go!
+		write4bits(0x03 << 4); 
+		return 1; // wait min 150us
+
+	case 5:
+		// finally, set to 4-bit interface
+		write4bits(0x02 << 4); 
+
+		// set # lines, font size, etc.
+		command(LCD_FUNCTIONSET | _displayfunction);  
+		
+		// turn the display on with no cursor or blinking default
+		_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+		display();
+		
+		// clear it off
+		command(LCD_CLEARDISPLAY);
+		return 2; // this command takes a long time!
+
+	case 6:
+		// Initialize to default text direction (for roman languages)
+		_displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+		
+		// set the entry mode
+		command(LCD_ENTRYMODESET | _displaymode);
+		
+		command(LCD_RETURNHOME);  // set cursor position to zero
+		return 2; // this command takes a long time!
+
+	default:
+		return LCD_BEGIN_DONE;
+	}
 }
 
 /********** high level commands, for the user! */
@@ -126,15 +153,14 @@ void home(void){
     return;
 }
 
-void setCursor(uint8_t col, uint8_t row){
+// Returns 0 if the I2C queue had no room, see I2C_M_write_buf
+uint8_t setCursor(uint8_t col, uint8_t row){
     
 	int row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
 	if (row > _rows) {
 		row = _rows-1;    // we count rows starting w/0
 	}
-	command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
-    
-    return;
+	return command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
 }
 
 // Turn the display on/off (quickly)
@@ -267,16 +293,14 @@ void backlight(void){
 
 /*********** mid level commands, for sending data/cmds */
 
-void command(uint8_t value){
+uint8_t command(uint8_t value){
 	
-    send(value, 0);
-    
-    return;
+    return sendStream(&value, 1, 0);
 }
 
  void write(uint8_t value){
     
-	send(value, Rs);
+	sendStream(&value, 1, Rs);
     
     return;
 }
@@ -284,21 +308,61 @@ void command(uint8_t value){
 
 /************ low level data pushing commands **********/
 
-// write either command or data
+// write either command or data, one blocking I2C transaction per expander update (expanderWrite)
+// kept to compare against sendStream(), which replaces it everywhere else
 void send(uint8_t value, uint8_t mode){
     
 	uint8_t highnib=value&0xf0;
 	uint8_t lownib=(value<<4)&0xf0;
-	write4bits((highnib)|mode);
-	write4bits((lownib)|mode); 
+	expanderWrite((highnib)|mode);
+	pulseEnable((highnib)|mode);
+	expanderWrite((lownib)|mode);
+	pulseEnable((lownib)|mode);
     
     return;
 }
 
+// The PCF8574 updates its pins after every byte of a write, so one I2C transaction can carry a whole run of
+// characters: mode, then data|En, data for each nibble. At 100kHz each byte holds the pins for 90us, which
+// is the enable pulse (>450ns) and the settle time between characters (>37us) without any busy waits.
+#if CY_PSOC5 && (I2C_Master_DATA_RATE > 200u)
+#error "sendStream() times the LCD by I2C byte time, I2C_Master must run at 200kHz or less"
+#endif
+
+// Returns the number of characters queued, fewer than len if the I2C queue filled up
+uint8_t sendStream(const uint8_t *values, uint8_t len, uint8_t mode){
+	
+	uint8_t buf[1 + 4 * LCD_STREAM_CHARS];
+	uint8_t i, n, highnib, lownib, sent = 0;
+	
+	while (len) {
+		n = 0;
+		buf[n++] = mode | _backlightval;	// RS settles before the first enable pulse
+		for (i = 0; i < len && i < LCD_STREAM_CHARS; i++) {
+			highnib = (values[i] & 0xf0) | mode | _backlightval;
+			lownib = ((values[i] << 4) & 0xf0) | mode | _backlightval;
+			buf[n++] = highnib | En;
+			buf[n++] = highnib;
+			buf[n++] = lownib | En;
+			buf[n++] = lownib;
+		}
+		if (!I2C_M_write_buf(_addr, buf, n)) break;
+		values += i;
+		len -= i;
+		sent += i;
+	}
+    
+    return sent;
+}
+
 void write4bits(uint8_t value) {
     
-	expanderWrite(value);
-	pulseEnable(value);
+	uint8_t buf[3];
+	
+	buf[0] = value | _backlightval;
+	buf[1] = value | En | _backlightval;
+	buf[2] = value | _backlightval;
+	I2C_M_write_buf(_addr, buf, 3);
     
     return;
 }
@@ -338,23 +402,22 @@ void setBacklight(uint8_t new_val){
     return;
 }
 
-void LCD_print(char word[]){ uint32_t i = 0;
-    
-    uint8_t size = strlen(word);
+void LCD_print(char word[]){
     
-    for (i = 0; i < size; i++){
-        write(word[i]);
-    }
+    sendStream((const uint8_t *)word, strlen(word), Rs);
 
     return;
 }
 
+// Blocking: waits for the bus and for its own transaction, like the MPU6050 register functions
 void I2C_M_write_byte(uint8_t addr,uint8_t data){ 
 
 #if CY_PSOC5
+    I2cQ_Lock();
     I2C_Master_MasterSendStart(addr, 0);
     I2C_Master_MasterWriteByte(data);
     I2C_Master_MasterSendStop();
+    I2cQ_Unlock();
 #elif CY_PSOC4
     I2C_I2CMasterSendStart(addr, 0);
     I2C_I2CMasterWriteByte(data);
@@ -363,3 +426,18 @@ void I2C_M_write_byte(uint8_t addr,uint8_t data){
     
     return;
 }
+
+uint8_t I2C_M_write_buf(uint8_t addr, const uint8_t *data, uint8_t len){ 
+    
+#if CY_PSOC5
+    // Low priority on the shared bus, the MPU6050 goes first. Never waits: a full queue is the caller's to retry.
+    return I2cQ_Write(I2CQ_LOW, addr, data, len, 0);
+#elif CY_PSOC4
+	uint8_t i;
+	
+    I2C_I2CMasterSendStart(addr, 0);
+    for (i = 0; i < len; i++) I2C_I2CMasterWriteByte(data[i]);
+    I2C_I2CMasterSendStop();
+    return 1;
+#endif
+}
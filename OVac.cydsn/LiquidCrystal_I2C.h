@@ -51,6 +51,9 @@
 #define Rw 0x02  // Read/Write bit
 #define Rs 0x01  // Register select bit
 
+#define LCD_BEGIN_DONE 0xFFFF  // beginStep() has run every step
+#define LCD_STREAM_CHARS 3     // Characters per sendStream() I2C transaction, 13 bytes (1.2ms at 100kHz)
+
 /**
  * This is the driver for the Liquid Crystal LCD displays that use the I2C bus.
  *
@@ -70,12 +73,28 @@
 */
 void LiquidCrystal_I2C_init(uint8_t lcd_addr, uint8_t lcd_cols, uint8_t lcd_rows, uint8_t charsize);
 	
+/*
+ * Write one byte to the expander and wait for it, taking the bus from the queue with I2cQ_Lock.
+ * For start up and the byte by byte benchmark baseline, not for the display task.
+*/
 void I2C_M_write_byte(uint8_t addr, uint8_t data);
 
+/*
+ * Write len bytes to the expander in one I2C transaction. On PSoC 5 the transaction is
+ * queued behind the bus and the call returns straight away, 0 if the queue was full.
+*/
+uint8_t I2C_M_write_buf(uint8_t addr, const uint8_t *data, uint8_t len);
+
 /*
  * Set the LCD display in the correct begin state, must be called before anything else is done.
 */
 void begin(void);
+
+/*
+ * begin() split at its waits. Call with step 0, 1, 2... waiting the returned number of
+ * milliseconds before each next call, until it returns LCD_BEGIN_DONE.
+*/
+uint16_t beginStep(uint8_t step);
 	
 /*
  * Remove all the characters currently shown. Next print/write operation will start
@@ -133,15 +152,16 @@ void backlight(void);
 void autoscroll(void);
 void noAutoscroll(void); 
 void createChar(uint8_t, uint8_t[]);
-void setCursor(uint8_t, uint8_t); 
+uint8_t setCursor(uint8_t, uint8_t); 
 void write(uint8_t);
-void command(uint8_t);        
+uint8_t command(uint8_t);        
 void LCD_print(char word[]);
 
 // Compatibility API function aliases
 void setBacklight(uint8_t new_val);				// alias for backlight() and nobacklight()
 void load_custom_character(uint8_t char_num, uint8_t *rows);	// alias for createChar()	 
 void send(uint8_t, uint8_t);
+uint8_t sendStream(const uint8_t *values, uint8_t len, uint8_t mode);
 void write4bits(uint8_t);
 void expanderWrite(uint8_t);
 void pulseEnable(uint8_t);
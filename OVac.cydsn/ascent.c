@@ -0,0 +1,66 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "ascent.h"
+#include "solenoid.h"
+
+/* Start an ascent from depth_cm with the valve closed */
+void Ascent_Start(ASCENT *a, int32_t depth_cm){
+    a->last_cm = depth_cm;
+    a->start_cm = depth_cm;
+    a->rate = 0;
+    a->rate_max = 0;
+    a->integral = 0;
+    a->ms = 0;
+    a->surface_ms = 0;
+    a->duty = 0;
+}
+
+/* One control step on the latest depth. Returns ASC_RISING with the lift valve duty in a->duty, or how the
+ * ascent ended. */
+uint8_t Ascent_Step(ASCENT *a, int32_t depth_cm){
+    int32_t raw, err, duty;
+
+    a->ms += ASC_PERIOD_MS;
+    raw = (a->last_cm - depth_cm) * (int32_t)(1000u / ASC_PERIOD_MS);
+    a->last_cm = depth_cm;
+    a->rate += (raw - a->rate) / (1 << ASC_RATE_SHIFT);
+    if (a->rate > a->rate_max) a->rate_max = a->rate;
+
+    if (depth_cm <= ASC_SURFACE_CM) a->surface_ms += ASC_PERIOD_MS;
+    else a->surface_ms = 0;
+    if (a->surface_ms >= ASC_SURFACE_MS){
+        a->duty = 0;
+        return ASC_SURFACED;
+    }
+    if (a->ms >= ASC_TIMEOUT_MS){
+        a->duty = 0;
+        return ASC_TIMEOUT;
+    }
+
+    err = ASC_RATE_CM_S - a->rate;
+    duty = ASC_KP * err + a->integral;
+    if (duty < (int32_t)(SOL_FULL << 8) || err < 0){         // Integrate only while it can still act
+        a->integral += ASC_KI * err;
+        if (a->integral < 0) a->integral = 0;
+        if (a->integral > (int32_t)(SOL_FULL << 8)) a->integral = SOL_FULL << 8;
+        duty = ASC_KP * err + a->integral;
+    }
+    if (duty < 0) duty = 0;
+    if (duty > (int32_t)(SOL_FULL << 8)) duty = SOL_FULL << 8;
+    duty = (duty + 128) >> 8;                               // Nearest step Sol_Tick can make, see solenoid.h
+    if (duty < (int32_t)SOL_DUTY_MIN || depth_cm <= ASC_SURFACE_CM) duty = 0;
+    else if (duty > (int32_t)(SOL_FULL - SOL_DUTY_MIN)) duty = SOL_FULL;  // Too short a gap to close in
+    a->duty = (uint8_t)duty;
+    return ASC_RISING;
+}
+
+/* [] END OF FILE */
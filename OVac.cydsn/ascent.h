@@ -0,0 +1,62 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _ASCENT_H_
+#define _ASCENT_H_
+
+/* Closed loop ascent on the lift bag.
+ *
+ * The bag is open at the bottom and only has an inflation valve, so gas can be added but not let out. The
+ * gas needed to leave the bottom grows with depth (Boyle), and once the device is rising the gas expands
+ * and it speeds up by itself. A fixed inflation pattern is therefore too little at depth and far too much
+ * near the surface. Ascent_Step runs every ASC_PERIOD_MS on the depth from the pressure sensor: it
+ * estimates the ascent rate and sets the lift valve duty with a PI controller to hold ASC_RATE_CM_S. At
+ * rest on the bottom the proportional term opens the valve most of the way and the integral takes it the
+ * rest; the integral stops building once the valve is full open, so it cannot wind up while the device is
+ * still stuck. Once the rate is reached the valve closes and the expanding gas does the rest.
+ *
+ * The ascent is over once the depth has stayed within ASC_SURFACE_CM of the surface for ASC_SURFACE_MS,
+ * or after ASC_TIMEOUT_MS whatever the depth says. The gains were tuned against the buoyancy model in the
+ * host simulator (sim/plant.c). */
+
+#define ASC_PERIOD_MS           100u
+#define ASC_RATE_CM_S           30          // Target ascent rate
+#define ASC_KP                  512         // Duty per 256 per cm/s below the rate
+#define ASC_KI                  16          // Duty per 256 added each step per cm/s below the rate
+#define ASC_RATE_SHIFT          2u          // Rate filter, 1/4 of each new difference
+#define ASC_SURFACE_CM          50
+#define ASC_SURFACE_MS          1000u
+#define ASC_TIMEOUT_MS          180000u
+
+/* Ascent_Step results */
+#define ASC_RISING              0u
+#define ASC_SURFACED            1u
+#define ASC_TIMEOUT             2u
+
+typedef struct ASCENT{
+    int32_t last_cm;                        // Depth at the previous step
+    int32_t rate;                           // Filtered ascent rate, cm/s, up is positive
+    int32_t integral;                       // Integral term, duty << 8
+    int32_t start_cm;
+    int32_t rate_max;
+    uint32_t ms;                            // Since Ascent_Start
+    uint32_t surface_ms;                    // Time spent near the surface so far
+    uint8_t duty;
+}ASCENT;
+
+void Ascent_Start(ASCENT *a, int32_t depth_cm);
+
+uint8_t Ascent_Step(ASCENT *a, int32_t depth_cm);
+
+#endif /* _ASCENT_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,255 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <stdio.h>
+#include <string.h>
+#include <FS.h>
+#include <mpu6050.h>
+#include "config.h"
+#include "benchmark.h"
+
+#ifdef BENCHMARK
+
+#warning "BENCHMARK build: the board runs the microbenchmarks, not the dive"
+
+#include "LiquidCrystal_I2C.h"
+#include "functions.h"
+#include "protocol.h"
+#include "bluetooth.h"
+#include "profile.h"
+#include "detect.h"
+#include "i2c_queue.h"
+#include "fmt.h"
+#include "spectrum.h"
+
+#define MA_CALLS                16u         // Moving average updates per timed run, too quick to time one
+
+typedef struct BENCH_CASE{
+    const char *name;
+    void (*run)(uint16_t arg);
+    uint16_t arg;
+    uint8_t calls;                          // Calls to the primitive per run
+}BENCH_CASE;
+
+static uint8_t i2c_buf[14];
+static volatile float ma_float;
+static volatile int32_t ma_int, ma_q4;
+static volatile int16_t motion[6];
+static char text[64];
+static SPEC_WINDOW spec_win;
+static SPEC_GOERTZEL spec_band;
+static uint32_t spec_power[SPEC_FFT_N / 2u];
+#ifdef SD
+static uint8_t fs_buf[BENCH_FS_MAX];
+static FS_FILE *fs_file;
+#endif
+
+/* Fixed inputs: a descent at about 1g */
+static const int16_t samples[MA_CALLS] = {
+    16384, 16102, 16650, 15990, 17011, 16384, 16220, 16507, 15875, 16843, 16384, 16001, 16799, 16120, 16450, 16384
+};
+
+static void Nothing(uint16_t arg){
+}
+
+static void I2c_Read(uint16_t len){
+    I2CReadBytes(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_XOUT_H, (uint8_t)len, i2c_buf);
+}
+
+static void Motion6(uint16_t arg){
+    int16_t m[6];
+    
+    MPU6050_getMotion6(&m[0], &m[1], &m[2], &m[3], &m[4], &m[5]);
+    motion[2] = m[2];
+}
+
+/* The float moving average of Descend_Tick */
+static void Ma_Float(uint16_t arg){
+    uint8_t i;
+    
+    for (i = 0; i < MA_CALLS; i++) ma_float = ComputeMA(ma_float, MA_WINDOW, samples[i]);
+}
+
+/* Fixed point alternatives: the same update on an integer, with a divide */
+static void Ma_Div(uint16_t arg){
+    uint8_t i;
+    
+    for (i = 0; i < MA_CALLS; i++) ma_int += (samples[i] - ma_int) / (int32_t)MA_WINDOW;
+}
+
+/* and with a power of two window, average << DETECT_HOLD_SHIFT as Detect_Hold keeps it */
+static void Ma_Shift(uint16_t arg){
+    uint8_t i;
+    
+    for (i = 0; i < MA_CALLS; i++) ma_q4 += samples[i] - (ma_q4 >> DETECT_HOLD_SHIFT);
+}
+
+/* A pressure line as the sample task used to log it, for comparison */
+static void Format_Log(uint16_t arg){
+    sprintf(text, "pressure: %d.%04d, %d\n", 1, 2345, -120);
+}
+
+/* and as it does now, see fmt.h */
+static void Fmt_Log(uint16_t arg){
+    FMT f;
+    
+    Fmt_Begin(&f, text, sizeof(text), &line_pressure);
+    Fmt_Fixed(&f, 12345, 4);
+    Fmt_Template(&f, &line_pressure_sep);
+    Fmt_Int(&f, -120, 0);
+    Fmt_Char(&f, '\n');
+}
+
+#ifdef SD
+static void Fs_Write(uint16_t len){
+    FS_Write(fs_file, fs_buf, len);
+}
+#endif
+
+/* One character to the LCD, until it is off the bus */
+static void Lcd_Char(uint16_t arg){
+    setCursor(15, 1);
+    write('0');
+    I2cQ_Drain();
+}
+
+/* Queue a text message for the Bluetooth UART: the cost to the caller, none of the time on the wire */
+static void Bt_Text(uint16_t arg){
+    Proto_SendText("bench 0123456789 abcdefghij");
+}
+
+/* The same message until the stop bit of its last byte is on the wire, the time at the link's baud rate.
+ * TX_STS_COMPLETE is sticky and only BT_TxService reads the status while the ring holds data, so once the
+ * ring is empty the next COMPLETE is the FIFO running dry after the last byte. */
+static void Bt_Sent(uint16_t arg){
+    (void)UART_ReadTxStatus();                  // Clear a COMPLETE left by the last message
+    Proto_SendText("bench 0123456789 abcdefghij");
+    while (BT_TxPending()) CY_PM_WFI;
+    while (!(UART_ReadTxStatus() & UART_TX_STS_COMPLETE));
+}
+
+/* One axis of a full IMU window, az is the spectrum task's work each run in the suction */
+static void Fft(uint16_t axis){
+    Spec_Fft(&spec_win, (uint8_t)axis, spec_power);
+}
+
+/* A block of the suction band, one call per sample as Suc_Sample makes them */
+static void Goertzel(uint16_t bins){
+    uint8_t i;
+    
+    Spec_GoertzelReset(&spec_band, 4u, (uint8_t)bins);
+    for (i = 0; i < SPEC_BLOCK; i++) Spec_Goertzel(&spec_band, samples[i & (MA_CALLS - 1u)]);
+}
+
+static const BENCH_CASE cases[] = {
+    { "i2c_read_1",       I2c_Read,   1,    1        },
+    { "i2c_read_2",       I2c_Read,   2,    1        },
+    { "i2c_read_6",       I2c_Read,   6,    1        },
+    { "i2c_read_14",      I2c_Read,   14,   1        },
+    { "mpu_motion6",      Motion6,    0,    1        },
+    { "computema_float",  Ma_Float,   0,    MA_CALLS },
+    { "ma_int_div",       Ma_Div,     0,    MA_CALLS },
+    { "ma_int_shift",     Ma_Shift,   0,    MA_CALLS },
+    { "sprintf_log",      Format_Log, 0,    1        },
+    { "fmt_log",          Fmt_Log,    0,    1        },
+#ifdef SD
+    { "fs_write_32",      Fs_Write,   32,   1        },
+    { "fs_write_512",     Fs_Write,   512,  1        },
+    { "fs_write_4096",    Fs_Write,   4096, 1        },
+#endif
+#ifdef LCD
+    { "lcd_char",         Lcd_Char,   0,    1        },
+#endif
+    { "bt_text_enqueue",  Bt_Text,    0,    1        },
+    { "bt_text_sent",     Bt_Sent,    0,    1        },
+    { "fft_64",           Fft,        0,    1        },
+    { "goertzel_32x5",    Goertzel,   5,    1        },
+    { "goertzel_32x8",    Goertzel,   8,    1        },
+};
+
+/* Send a line, waiting for room in the Bluetooth ring */
+static void Send(const char *line){
+    while (!Proto_SendText(line)) CY_PM_WFI;
+}
+
+/* Time one case. Returns its minimum, so the empty case gives the cost of the timing itself. */
+static uint32_t Time(const BENCH_CASE *c, uint32_t overhead){
+    char line[96];
+    FMT f;
+    uint32_t start, cycles, min = 0xFFFFFFFFu, max = 0;
+    uint64_t sum = 0;
+    uint16_t i;
+    
+    for (i = 0; i < BENCH_REPS; i++){
+        start = PROF_CYCLES();
+        c->run(c->arg);
+        cycles = PROF_CYCLES() - start;
+        cycles = (cycles > overhead) ? cycles - overhead : 0u;
+        if (c->run == Bt_Text) while (BT_TxPending()) CY_PM_WFI;    // Keep the ring from filling
+        sum += cycles;
+        if (cycles < min) min = cycles;
+        if (cycles > max) max = cycles;
+    }
+    if (c->run != Nothing){
+        Fmt_Start(&f, line, sizeof(line));
+        FMT_LIT(&f, "bench ");
+        Fmt_Str(&f, c->name);
+        FMT_LIT(&f, " n ");
+        Fmt_Uint(&f, BENCH_REPS, 0, ' ');
+        FMT_LIT(&f, " min ");
+        Fmt_Uint(&f, min / c->calls, 0, ' ');
+        FMT_LIT(&f, " mean ");
+        Fmt_Uint(&f, (uint32_t)(sum / BENCH_REPS / c->calls), 0, ' ');
+        FMT_LIT(&f, " max ");
+        Fmt_Uint(&f, max / c->calls, 0, ' ');
+        Send(line);
+    }
+    return min;
+}
+
+/* Run the suite and report it. Needs the boot jobs done: the I2C bus, the MPU6050, the LCD and the SD card. */
+void Bench_Run(void){
+    static const BENCH_CASE empty = { "empty", Nothing, 0, 1 };
+    uint32_t overhead;
+    FMT f;
+    uint8_t i;
+    
+    Prof_Start();
+    overhead = Time(&empty, 0);
+    #ifdef SD
+        memset(fs_buf, 'b', sizeof(fs_buf));
+        fs_file = FS_FOpen("bench.bin", "w");
+    #endif
+    
+    for (i = 0; i < SPEC_FFT_N; i++) Spec_Push(&spec_win, samples[i & (MA_CALLS - 1u)], samples[i & 7u], 0, 0);
+    
+    Send("bench start");
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        #ifdef SD
+            if (cases[i].run == Fs_Write && !fs_file) continue;
+        #endif
+        Time(&cases[i], overhead);
+    }
+    
+    #ifdef SD
+        if (fs_file) FS_FClose(fs_file);
+        FS_Remove("bench.bin");
+    #endif
+    Fmt_Start(&f, text, sizeof(text));
+    FMT_LIT(&f, "bench done overhead ");
+    Fmt_Uint(&f, overhead, 0, ' ');
+    Send(text);
+}
+
+#endif /* BENCHMARK */
+
+/* [] END OF FILE */
@@ -0,0 +1,34 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+/* On-target microbenchmarks, the BENCHMARK build.
+ *
+ * With BENCHMARK defined, in config.h or in the Preprocessor Definitions of the build settings, the board boots as usual and main() then runs Bench_Run instead of the dive:
+ * a fixed suite of the primitives the firmware spends its time in, each BENCH_REPS times on the DWT cycle
+ * counter (24 cycles per us), with one RSP_TEXT line per case:
+ *   bench <name> n <reps> min <cycles> mean <cycles> max <cycles>
+ * Counts are per call, less the cost of reading the counter. Interrupts stay on, as the primitives need
+ * them, so mean and max include the odd ISR; min is the figure to compare between builds. Inputs are fixed,
+ * so the same firmware gives the same min on every run. The build says it is one with a #warning, and
+ * `make firmware` in sim/ checks that it compiles. */
+
+#define BENCH_REPS              64u
+#define BENCH_FS_MAX            4096u       // Largest FS_Write case
+
+void Bench_Run(void);
+
+#endif /* _BENCHMARK_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,113 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "bluetooth.h"
+
+static uint8_t tx_ring[BT_TX_BUFFER_LEN];
+static volatile uint16_t tx_head = 0;       // Next free slot, advanced by writers
+static volatile uint16_t tx_tail = 0;       // Next byte to send, advanced by BT_TxService()
+
+volatile BT_TX_STATS bt_tx_stats;
+
+/* Reset the ring and counters, call once after UART_Start() */
+void BT_TxStart(void){
+    uint8 intState = CyEnterCriticalSection();
+    tx_head = 0;
+    tx_tail = 0;
+    memset((void *)&bt_tx_stats, 0, sizeof(bt_tx_stats));
+    #ifdef BT_TX_IRQ
+        UART_SetTxInterruptMode(0);                         // Masked until there is something to send
+        bt_tx_isr_StartEx(BT_Tx_ISR_Handler);
+    #endif
+    CyExitCriticalSection(intState);
+}
+
+uint16_t BT_TxPending(void){
+    return (uint16_t)(tx_head - tx_tail) & BT_TX_BUFFER_MASK;
+}
+
+uint16_t BT_TxFree(void){
+    return (BT_TX_BUFFER_LEN - 1u) - BT_TxPending();    // One slot kept open to tell full from empty
+}
+
+/* Queue a message for transmission. Never waits on the UART; returns 1 if the whole message was queued, 0 if
+ * any of it was dropped. Safe to call from the main loop and from ISRs. */
+uint8_t BT_Write(const void *data, uint16_t len){
+    const uint8_t *src = (const uint8_t *)data;
+    uint16_t space, first, pending;
+    uint8_t whole = 1;
+    uint8 intState;
+
+    if (len == 0) return 1;
+
+    intState = CyEnterCriticalSection();
+    space = BT_TxFree();
+    if (len > space){
+        bt_tx_stats.dropped_msgs++;
+    #if (BT_TX_OVERFLOW_POLICY == BT_TX_TRUNCATE)
+        bt_tx_stats.dropped_bytes += len - space;
+        len = space;
+    #else
+        bt_tx_stats.dropped_bytes += len;
+        len = 0;
+    #endif
+        whole = 0;
+    }
+
+    if (len){
+        first = BT_TX_BUFFER_LEN - tx_head;                 // Copy in at most two pieces around the wrap
+        if (first > len) first = len;
+        memcpy(&tx_ring[tx_head], src, first);
+        memcpy(&tx_ring[0], src + first, len - first);
+        tx_head = (tx_head + len) & BT_TX_BUFFER_MASK;
+        bt_tx_stats.queued_bytes += len;
+
+        pending = BT_TxPending();
+        if (pending > bt_tx_stats.high_water) bt_tx_stats.high_water = pending;
+
+        BT_TxService();                                     // Prime the FIFO so short messages leave right away
+        #ifdef BT_TX_IRQ
+            if (tx_tail != tx_head) UART_SetTxInterruptMode(UART_TX_STS_FIFO_NOT_FULL);    // The ISR sends the rest
+        #endif
+    }
+    CyExitCriticalSection(intState);
+
+    return whole;
+}
+
+uint8_t BT_Print(const char *str){
+    return BT_Write(str, strlen(str));
+}
+
+/* Move queued bytes into the UART FIFO until it is full or the ring is empty. Runs in interrupt context (or
+ * with interrupts disabled from BT_Write), so it is the only consumer of the ring at any time. Masks the TX
+ * interrupt once the ring is empty. */
+void BT_TxService(void){
+    uint16_t tail = tx_tail;
+
+    while (tail != tx_head && (UART_ReadTxStatus() & UART_TX_STS_FIFO_NOT_FULL)){
+        UART_WriteTxData(tx_ring[tail]);
+        tail = (tail + 1u) & BT_TX_BUFFER_MASK;
+        bt_tx_stats.sent_bytes++;
+    }
+    tx_tail = tail;
+    #ifdef BT_TX_IRQ
+        if (tail == tx_head) UART_SetTxInterruptMode(0);
+    #endif
+}
+
+/* UART TX FIFO-not-full interrupt, bt_tx_isr */
+CY_ISR(BT_Tx_ISR_Handler){
+    BT_TxService();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,65 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <stdint.h>
+
+#ifndef _BLUETOOTH_H_
+#define _BLUETOOTH_H_
+
+/* Non-blocking Bluetooth transmit path.
+ *
+ * Callers copy a message into a software ring buffer and return immediately. The ring is drained into the
+ * 4-byte UART TX FIFO by BT_TxService(), in interrupt context. With an isr component named bt_tx_isr on the
+ * UART tx_interrupt terminal (level, the UART's TX FIFO-not-full status) it runs from BT_Tx_ISR_Handler: the
+ * FIFO-not-full source is unmasked only while the ring holds data and masked again as it empties, so an idle
+ * link takes no interrupts. Designs without bt_tx_isr refill the FIFO from the 1ms Countdown_ISR instead,
+ * 4 bytes a millisecond, which still covers 38400 baud. */
+
+#if defined(CY_ISR_bt_tx_isr_H)
+    #define BT_TX_IRQ                       // bt_tx_isr is in the design, the ring is interrupt driven
+#endif
+
+#define BT_TX_BUFFER_LEN    512u            // Must be a power of two
+#define BT_TX_BUFFER_MASK   (BT_TX_BUFFER_LEN - 1u)
+
+/* Overflow policies */
+#define BT_TX_DROP_MESSAGE  0u              // Reject the whole message if it does not fit (messages never split)
+#define BT_TX_TRUNCATE      1u              // Queue as much of the message as fits
+
+#define BT_TX_OVERFLOW_POLICY   BT_TX_DROP_MESSAGE
+
+typedef struct BT_TX_STATS{
+    uint32_t queued_bytes;                  // Bytes accepted into the ring
+    uint32_t sent_bytes;                    // Bytes moved into the UART FIFO
+    uint32_t dropped_msgs;                  // Messages rejected or truncated due to overflow
+    uint32_t dropped_bytes;                 // Bytes lost due to overflow
+    uint16_t high_water;                    // Most bytes ever waiting in the ring
+}BT_TX_STATS;
+
+extern volatile BT_TX_STATS bt_tx_stats;
+
+void BT_TxStart(void);
+
+uint8_t BT_Write(const void *data, uint16_t len);
+
+uint8_t BT_Print(const char *str);
+
+void BT_TxService(void);
+
+uint16_t BT_TxPending(void);
+
+uint16_t BT_TxFree(void);
+
+CY_ISR_PROTO(BT_Tx_ISR_Handler);
+
+#endif /* _BLUETOOTH_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,81 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "boot.h"
+#include "clock.h"
+#include "protocol.h"
+#include "fmt.h"
+
+static BOOT_STAMP stamps[BOOT_MAX_STAMPS];
+static uint8_t stamp_count = 0;
+
+/* Record that a boot stage has been reached. Marks past BOOT_MAX_STAMPS are dropped. */
+void Boot_Mark(const char *name){
+    if (stamp_count >= BOOT_MAX_STAMPS) return;
+    stamps[stamp_count].name = name;
+    stamps[stamp_count].us = Clock_Us();
+    stamp_count++;
+}
+
+/* Run every job to completion, interleaving their steps. Needs the clock running: the 1ms countdown
+ * interrupt ends each WFI, so a wait overruns by a millisecond at most. */
+void Boot_Run(BOOT_JOB *jobs, uint8_t count){
+    uint16_t wait;
+    uint8_t i, pending, ran;
+
+    for (i = 0; i < count; i++){
+        jobs[i].next = 0;
+        jobs[i].due = clock_ms;
+    }
+
+    do {
+        pending = 0;
+        ran = 0;
+        for (i = 0; i < count; i++){
+            if (jobs[i].next == 0xFFu) continue;
+            pending = 1;
+            if ((int32_t)(clock_ms - jobs[i].due) < 0) continue;
+            wait = jobs[i].step(jobs[i].next++);
+            ran = 1;
+            if (wait == BOOT_DONE){
+                jobs[i].next = 0xFFu;
+                Boot_Mark(jobs[i].name);
+            } else {
+                jobs[i].due = clock_ms + wait + 1u;     // clock_ms may be about to tick, wait a whole ms more
+            }
+        }
+        if (pending && !ran) CY_PM_WFI;
+    } while (pending);
+}
+
+/* Microseconds from Clock_Start to the last mark */
+uint32_t Boot_Time(void){
+    return stamp_count ? stamps[stamp_count - 1u].us : 0;
+}
+
+/* Send each stamp as "boot <stage> <us>" */
+void Boot_Report(void){
+    char line[32];
+    FMT f;
+    uint8_t i;
+
+    for (i = 0; i < stamp_count; i++){
+        Fmt_Start(&f, line, sizeof(line));
+        FMT_LIT(&f, "boot ");
+        Fmt_Str(&f, stamps[i].name);
+        Fmt_Char(&f, ' ');
+        Fmt_Uint(&f, stamps[i].us, 0, ' ');
+        Proto_SendText(line);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,53 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+/* Boot sequencing and profiling.
+ *
+ * Peripheral start up is split into jobs made of steps, where each step does its register writes and returns
+ * how long the part needs before the next one. Boot_Run interleaves the jobs, so the LCD's power up waits,
+ * the MPU6050's start up time and the SD mount overlap instead of adding up, and halts the CPU between steps.
+ *
+ * Boot_Mark stamps a named stage with Clock_Us, which starts at zero in Clock_Start at the top of main. Each
+ * job is stamped as it finishes and Boot_Report sends the stamps over the Bluetooth UART as text. */
+
+#define BOOT_DONE               0xFFFFu     // Step return: the job has finished
+#define BOOT_MAX_STAMPS         12u
+
+/* Run step n of a job, return the milliseconds to wait before step n+1 or BOOT_DONE */
+typedef uint16_t (*BOOT_STEP)(uint8_t step);
+
+typedef struct BOOT_JOB{
+    const char *name;                       // Stamped when the job finishes
+    BOOT_STEP step;
+    uint8_t next;                           // Step to run next
+    uint32_t due;                           // clock_ms it may run at
+}BOOT_JOB;
+
+typedef struct BOOT_STAMP{
+    const char *name;
+    uint32_t us;                            // Clock_Us at the mark
+}BOOT_STAMP;
+
+void Boot_Mark(const char *name);
+
+void Boot_Run(BOOT_JOB *jobs, uint8_t count);
+
+uint32_t Boot_Time(void);
+
+void Boot_Report(void);
+
+#endif /* _BOOT_H_ */
+/* [] END OF FILE */
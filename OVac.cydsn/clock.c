@@ -0,0 +1,45 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "clock.h"
+
+volatile uint32_t clock_ms = 0;
+
+void Clock_Start(void){
+    Countdown_timer_Init();
+    Countdown_timer_WritePeriod(CLOCK_PERIOD);
+    Countdown_timer_WriteCounter(CLOCK_PERIOD);
+    Countdown_timer_Enable();
+}
+
+/* Called from the countdown ISR every millisecond */
+void Clock_Tick(void){
+    clock_ms++;
+}
+
+/* Microseconds since Clock_Start. Safe from ISRs: if the counter has reloaded but the countdown ISR has not
+ * run yet (we are in another ISR, or interrupts are masked) its pending bit says so. */
+uint32_t Clock_Us(void){
+    uint32_t ms, count, pending;
+    uint8_t s = CyEnterCriticalSection();
+
+    do {
+        pending = *countdown_INTC_SET_PD & countdown__INTC_MASK;
+        count = Countdown_timer_ReadCounter();
+    } while (pending != (*countdown_INTC_SET_PD & countdown__INTC_MASK));   // Reload between the two reads
+    ms = clock_ms + (pending ? 1u : 0u);
+    CyExitCriticalSection(s);
+
+    return ms * 1000u + (CLOCK_PERIOD - count) / CLOCK_BUS_MHZ;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,36 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+/* Millisecond system clock on Countdown_timer.
+ *
+ * The TopDesign sets the timer up for a 1 second period at BUS_CLK. Clock_Start reprograms it for 1 ms so
+ * its interrupt can drive the scheduler and the software timers: the countdown ISR calls Clock_Tick and then
+ * Timer_Tick. Clock_Us adds the position inside the current millisecond
+ * read back from the counter, giving a microsecond clock that wraps every 71 minutes. */
+
+#define CLOCK_BUS_MHZ           24u         // BUS_CLK, Countdown_timer counts per microsecond
+#define CLOCK_PERIOD            (CLOCK_BUS_MHZ * 1000u - 1u)
+
+extern volatile uint32_t clock_ms;         // Milliseconds since Clock_Start
+
+void Clock_Start(void);
+
+void Clock_Tick(void);
+
+uint32_t Clock_Us(void);
+
+#endif /* _CLOCK_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,32 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+/* Parts of the board in use, shared by main.c and dive.c */
+#define MPU6050 
+#define LCD
+//#define SD
+#define BT
+//#define PROFILE                       // DWT cycle counter probes and CMD_PROFILE, see profile.h
+//#define BENCHMARK                     // Run the microbenchmarks after boot instead of the dive, see benchmark.h
+//#define WATCHDOG                      // Reset when the main loop stalls, the kicks go in the flight recorder
+
+#ifdef SIM
+#define SD                              // Files in memory, see sim/hal_sim.c
+#undef PROFILE                          // The host simulator has no cycle counter
+#undef BENCHMARK
+#undef WATCHDOG
+#endif
+
+#endif /* _CONFIG_H_ */
+/* [] END OF FILE */
@@ -15,5 +15,9 @@
     /*Define your macro callbacks here */
     /*For more information, refer to the Macro Callbacks topic in the PSoC Creator Help.*/
     
+    /* I2C_Master interrupt exit, runs the transaction queue (i2c_queue.c) */
+    #define I2C_Master_ISR_EXIT_CALLBACK
+    void I2C_Master_ISR_ExitCallback(void);
+    
 #endif /* CYAPICALLBACKS_H */   
 /* [] */
@@ -0,0 +1,88 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdlib.h>
+#include "detect.h"
+#include "functions.h"
+
+/* One descent sample. The first MA_WINDOW samples only fill the sums; the gyro averages start from their
+ * mean, the z average starts from 0 and takes a few windows to reach 1g, well short of BOT_THRESHOLD. */
+uint8_t Detect_Ma(DETECT_MA *d, int16_t az, int16_t gx, int16_t gy){
+    if (d->id < MA_WINDOW){    
+        d->sum += az;  
+        d->xsum += gx;
+        d->ysum += gy;
+    }
+    else if(d->id == MA_WINDOW){
+        d->sum += az;
+        d->xsum += gx;
+        d->ysum += gy;
+        d->sum = d->sum/MA_WINDOW;
+        d->xavg = d->xsum/MA_WINDOW;                            
+        d->yavg = d->ysum/MA_WINDOW;
+    }
+    else{
+        d->average = ComputeMA(d->average, MA_WINDOW, az);          // Compute averages for gyro
+        d->xavg = ComputeMA(d->xavg, MA_WINDOW, gx);
+        d->yavg = ComputeMA(d->yavg, MA_WINDOW, gy);
+//        if (abs((int)d->xavg) > DEGREES_50 || abs((int)d->yavg) > DEGREES_50){ // If gyro sees intense rotation
+//            d->id++;
+//            return DETECT_TILT;                                       // start lift bag
+//        }
+    }
+    d->id++;
+    
+    if(d->average > BOT_THRESHOLD) return DETECT_BOTTOM;
+    return DETECT_NONE;
+}
+
+/* Gyro averages only, while sitting on the bottom */
+void Detect_MaGyro(DETECT_MA *d, int16_t gx, int16_t gy){
+    if (d->id < MA_WINDOW){    
+        d->xsum += gx;
+        d->ysum += gy;
+    }
+    else if(d->id == MA_WINDOW){
+        d->xsum += gx;
+        d->ysum += gy;
+        d->xavg = d->xsum/MA_WINDOW;                            //compute baseline average
+        d->yavg = d->ysum/MA_WINDOW;
+    }
+    else{
+        d->xavg = ComputeMA(d->xavg, MA_WINDOW, gx);
+        d->yavg = ComputeMA(d->yavg, MA_WINDOW, gy);
+    }
+    d->id++;
+}
+
+void Detect_HoldReset(DETECT_HOLD_STATE *d){
+    d->acc = 0;
+    d->primed = 0;
+    d->over = 0;
+}
+
+/* Integer moving average, primed with the first sample, over the threshold for DETECT_HOLD samples in a
+ * row. Gyro unused. */
+uint8_t Detect_Hold(DETECT_HOLD_STATE *d, int16_t az, int16_t gx, int16_t gy){
+    if (!d->primed){
+        d->acc = (int32_t)az << DETECT_HOLD_SHIFT;
+        d->primed = 1;
+    }
+    d->acc += az - (d->acc >> DETECT_HOLD_SHIFT);
+    if ((d->acc >> DETECT_HOLD_SHIFT) <= BOT_THRESHOLD){
+        d->over = 0;
+        return DETECT_NONE;
+    }
+    if (d->over < DETECT_HOLD) d->over++;
+    return (d->over == DETECT_HOLD) ? DETECT_BOTTOM : DETECT_NONE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,61 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _DETECT_H_
+#define _DETECT_H_
+
+/* Landing detection on the MPU6050 samples of the descent, one call per 2ms sample.
+ *
+ * Detect_Ma is the detector the dive runs (Descend_Tick): a ComputeMA moving average of the z acceleration
+ * against BOT_THRESHOLD, with the gyro averaged alongside for the tilt failsafe. Detect_Hold is a candidate
+ * kept next to it for the replay benchmark (sim/bench.c): an integer moving average that must stay over
+ * the threshold for DETECT_HOLD samples, so a short knock on the way down is not taken for the bottom.
+ * A new detector goes here with its state struct, and into the benchmark's detector table. */
+
+#define MA_WINDOW 15                    // Number of samples in the moving average window.
+#define BOT_THRESHOLD 20000             // Z-Aacceleration threshold for transition into LANDED state.
+#define DEGREES_20 (131 * 20)           // Gyro value corresponding to 30 degrees. Default setting is 131 LSB/degree/s 
+#define DEGREES_50 (131 * 50)           // So every 131 in gyro value equals 1 degree of rotational velocity
+
+#define DETECT_HOLD_SHIFT       4u      // Detect_Hold average over about 16 samples
+#define DETECT_HOLD             3u      // Samples over BOT_THRESHOLD before Detect_Hold reports the bottom
+
+/* Results */
+#define DETECT_NONE             0u
+#define DETECT_BOTTOM           1u
+#define DETECT_TILT             2u
+
+typedef struct DETECT_MA{
+    long id;                            // Samples seen
+    long sum;                           // Sum of accelerometer values
+    int16_t average;                    // Moving average, accelerometer
+    float xsum, ysum;                   // Gyro sums over the first window
+    float xavg, yavg;                   // Gyro moving averages
+}DETECT_MA;
+
+typedef struct DETECT_HOLD_STATE{
+    int32_t acc;                        // Average << DETECT_HOLD_SHIFT
+    uint8_t primed;
+    uint8_t over;                       // Consecutive samples over the threshold
+}DETECT_HOLD_STATE;
+
+uint8_t Detect_Ma(DETECT_MA *d, int16_t az, int16_t gx, int16_t gy);
+
+void Detect_MaGyro(DETECT_MA *d, int16_t gx, int16_t gy);
+
+void Detect_HoldReset(DETECT_HOLD_STATE *d);
+
+uint8_t Detect_Hold(DETECT_HOLD_STATE *d, int16_t az, int16_t gx, int16_t gy);
+
+#endif /* _DETECT_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,136 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "display.h"
+#include "LiquidCrystal_I2C.h"
+#include "i2c_queue.h"
+#include "clock.h"
+
+#define GAP_MAX                 2u          // Unchanged characters resent rather than moving the cursor
+
+DISPLAY_STATS display_stats;
+
+static char frame[DISPLAY_ROWS][DISPLAY_COLS];  // What the application wants shown
+static char shown[DISPLAY_ROWS][DISPLAY_COLS];  // What the LCD is showing
+static uint8_t cur_col = 0xFFu, cur_row = 0xFFu;    // LCD cursor, 0xFF when unknown
+static uint8_t dirty = 0;                       // frame and shown may differ
+
+/* Both buffers blank, which is how begin() leaves the LCD */
+void Display_Init(void){
+    memset(frame, ' ', sizeof(frame));
+    memset(shown, ' ', sizeof(shown));
+    cur_col = 0xFFu;
+    dirty = 0;
+}
+
+void Display_Clear(void){
+    memset(frame, ' ', sizeof(frame));
+    dirty = 1;
+}
+
+/* Write text from col along row, cut off at the end of the row */
+void Display_Text(uint8_t col, uint8_t row, const char *text){
+    if (row >= DISPLAY_ROWS) return;
+    while (col < DISPLAY_COLS && *text){
+        frame[row][col++] = *text++;
+    }
+    dirty = 1;
+}
+
+/* Replace a whole row, padding with spaces */
+void Display_Row(uint8_t row, const char *text){
+    if (row >= DISPLAY_ROWS) return;
+    memset(frame[row], ' ', DISPLAY_COLS);
+    Display_Text(0, row, text ? text : "");
+}
+
+/* Queue up to max characters for the LCD. Each run of changed characters in a row goes out as streamed I2C
+ * transactions, preceded by a cursor move unless the cursor is already there. Runs only a few unchanged
+ * characters apart are merged, resending those is cheaper than another cursor move. A run is only started if
+ * the low priority queue has room for all of it, so the flush never waits on the bus, and if the queue still
+ * refuses a transaction the flush stops there and picks up from the LCD's cursor next time. Returns the
+ * number of characters queued. */
+uint8_t Display_Flush(uint8_t max){
+    uint8_t row, col, start, end, n, sent = 0;
+
+    if (!dirty) return 0;
+    for (row = 0; row < DISPLAY_ROWS; row++){
+        col = 0;
+        while (col < DISPLAY_COLS){
+            if (frame[row][col] == shown[row][col]){ col++; continue; }
+            if (sent == max) return sent;                   // dirty stays set, the rest goes next time
+
+            start = col;
+            end = col + 1u;
+            for (col = end; col < DISPLAY_COLS && col - end <= GAP_MAX; col++){
+                if (frame[row][col] != shown[row][col]) end = col + 1u;
+            }
+            if (end - start > max - sent) end = start + (max - sent);
+            if (I2cQ_Free(I2CQ_LOW) < 1u + (end - start + LCD_STREAM_CHARS - 1u) / LCD_STREAM_CHARS){
+                return sent;                                // Bus backed up, try again next time
+            }
+
+            if (row != cur_row || start != cur_col){
+                if (!setCursor(start, row)) return sent;
+                cur_row = row;
+                cur_col = start;
+            }
+            n = sendStream((const uint8_t *)&frame[row][start], end - start, Rs);
+            memcpy(&shown[row][start], &frame[row][start], n);
+            cur_col = start + n;                            // The LCD advances the cursor itself
+            sent += n;
+            if (start + n != end) return sent;              // Queue filled up after all, the rest goes next time
+            col = end;
+        }
+    }
+    dirty = 0;
+    return sent;
+}
+
+/* Time a full row written the old way, one blocking I2C transaction per expander update with the enable
+ * pulse delays, against the same row streamed through the queue. Leaves the text on row 0 for the next flush
+ * to overwrite. */
+void Display_Benchmark(void){
+    static const char text[DISPLAY_COLS + 1] = "PSoC 5LP: O-Vac ";
+    uint32_t start;
+    uint8_t i;
+
+    I2cQ_Drain();                                           // Nothing queued may land in the middle of the row
+    start = Clock_Us();
+    send(LCD_SETDDRAMADDR, 0);                              // Row 0, column 0
+    for (i = 0; i < DISPLAY_COLS; i++) send((uint8_t)text[i], Rs);
+    display_stats.byte_us = Clock_Us() - start;
+
+    start = Clock_Us();
+    setCursor(0, 0);
+    sendStream((const uint8_t *)text, DISPLAY_COLS, Rs);
+    I2cQ_Drain();
+    display_stats.stream_us = Clock_Us() - start;
+
+    memcpy(shown[0], text, DISPLAY_COLS);
+    cur_row = 0;
+    cur_col = DISPLAY_COLS;
+    dirty = 1;
+}
+
+/* Characters per millisecond, x100, for a row taking us microseconds */
+uint16_t Display_Rate(uint32_t us){
+    if (us == 0) return 0;
+    return (uint16_t)((DISPLAY_COLS * 100000u) / us);
+}
+
+/* Returns 1 if the LCD may still differ from the framebuffer */
+uint8_t Display_Pending(void){
+    return dirty;
+}
+
+/* [] END OF FILE */
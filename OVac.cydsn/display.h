@@ -0,0 +1,59 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _DISPLAY_H_
+#define _DISPLAY_H_
+
+/* Shadow framebuffer for the 16x2 LCD.
+ *
+ * The application only writes text into RAM. Display_Flush compares it with a copy of what the LCD is
+ * showing and queues just the characters that differ, with a cursor move only where the changed characters
+ * are not contiguous. The transfers go on the low priority side of the shared I2C queue (i2c_queue.h), so
+ * an MPU6050 read never waits behind more than the one LCD transaction already on the bus. The flush stops
+ * after a set number of characters and the LCD task picks up the rest next time: with 8 characters every
+ * 100ms the whole 32 character screen converges within 400ms of the last framebuffer change.
+ *
+ * Nothing here uses the HD44780 clear or home commands, which take 2ms each: Display_Clear fills the
+ * framebuffer with spaces and the flush overwrites whatever was shown.
+ *
+ * Display_Benchmark times one row sent the old way and streamed (sendStream in LiquidCrystal_I2C.c), for the
+ * boot report. */
+
+#define DISPLAY_COLS            16u
+#define DISPLAY_ROWS            2u
+
+typedef struct DISPLAY_STATS{
+    uint32_t byte_us;                       // One row, one I2C transaction per expander update
+    uint32_t stream_us;                     // One row, streamed
+}DISPLAY_STATS;
+
+extern DISPLAY_STATS display_stats;
+
+void Display_Init(void);
+
+void Display_Clear(void);
+
+void Display_Text(uint8_t col, uint8_t row, const char *text);
+
+void Display_Row(uint8_t row, const char *text);
+
+uint8_t Display_Flush(uint8_t max);
+
+uint8_t Display_Pending(void);
+
+void Display_Benchmark(void);
+
+uint16_t Display_Rate(uint32_t us);
+
+#endif /* _DISPLAY_H_ */
+/* [] END OF FILE */
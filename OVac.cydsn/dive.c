@@ -0,0 +1,782 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "dive.h"
+#include "hal.h"
+#include "functions.h"
+#include "bluetooth.h"
+#include "protocol.h"
+#include "transfer.h"
+#include "telemetry.h"
+#include "events.h"
+#include "fsm.h"
+#include "clock.h"
+#include "sched.h"
+#include "power.h"
+#include "timer.h"
+#include "display.h"
+#include "detect.h"
+#include "profile.h"
+#include "jitter.h"
+#include "ram.h"
+#include "recorder.h"
+#include "fmt.h"
+#include "solenoid.h"
+#include "ascent.h"
+#include "suction.h"
+#include "spectrum.h"
+
+
+#define WAIT_TIME 1000                  // Number of ISR calls until transition into DESCENDING state.
+#define MAX_DEPTH 999                   // Largest depth in feet accepted from the depth command
+#define LAUNCH_SECONDS 10               // Countdown after the depth is set
+#define STATUS_SECONDS 10               // Seconds between status messages while waiting at the surface
+#define SETTLE_SECONDS 15               // Wait on the bottom before suction
+#define SUCTION_SECONDS 5               // Solenoid 1 on time of the default suction profile
+#define RELEASE_SECONDS 3               // Wait after suction before resurfacing
+#define LOG_BUF_LEN 1024                // SD log lines held between log task flushes
+#define LCD_FLUSH_CHARS 8               // Most LCD characters sent per LCD task run
+
+#define STATE ((STATES)dive.state)      // Current state, only ever changed by Fsm_Dispatch
+
+/* Software timers */
+#define TMR_LAUNCH 0                    // Launch countdown, EV_COUNTDOWN every second
+#define TMR_STAGE 1                     // Steps of the LANDED sequence and the RESURFACE control period, EV_STAGE
+#define TMR_STATUS 2                    // Status messages, EV_STATUS
+
+
+long press_id = 1;                      // Interrupt count.
+long data_time = 0;                     // data point num
+volatile uint32_t tick_count = 0;       // Sample_Timer ticks since boot
+static uint32_t ticks_seen = 0;         // tick_count at the last sample task run
+static uint32_t rec_due = 0;            // ticks_seen of the next flight recorder sensor summary
+long descent_time = 0;                  // Max number of seconds allowed for descent, x 500 because it uses the same 2ms timer
+
+float pressure_sum = 0;                 // Sum of pressure values. 
+static DETECT_MA imu_ma = { 1 };       // Accelerometer and gyro moving averages, see detect.h
+bool PANIC_flag = 0;                    // flag indicating water is present in housing.
+bool tilted = 0;                        // flag indicating the tilt failsafe sent the device up
+//bool first_test = 1;                  // flag indicating first test(longer countdown)
+static FSM dive;                                    // Dive state machine, see dive_table
+static SCHED sched;                                 // Periodic tasks, see tasks
+uint8_t countdown = 0;                              // Seconds counted by the launch countdown
+volatile int dataflag = 0;                                                    // UART variables
+int depth = 0;                                                                // Variable depth
+int testnum = 1;                        // Run number of the open log file
+char file[RUN_FILE_NAME_LEN];            // Open log file, Transfer_RunName of testnum
+
+/* Sensor and timing state shared by the actions */
+static float voltage = 0, output = 0, pressure_avg = 0;                 // ADC Voltage conversion variables
+static float surface_pressure = 0;                                      // Pressure average while waiting at the surface
+static uint32_t run_max = 0;                                            // Longest event run time, microseconds
+static uint16_t runs = 0;                                               // Events run since the last telemetry frame
+static char buf[50];                                                    // UART buffer
+static int status_first = 1;                                            // TRANSMITTING not yet sent this surfacing
+static int pulse = 0;
+static int16_t az, gx, gy, gz;
+static SOL_STEP suction[SOL_STEPS_MAX] = { { SOL_FULL, SUCTION_SECONDS * 1000u } };  // Set by CMD_SUCTION
+static SUCTION suc;                                                     // Flow analysis of the suction in LANDED
+static uint32_t suction_ms = 0;                                         // Suction profile length with its extensions
+static SPEC_WINDOW imu_win;                                             // Last SPEC_FFT_N IMU samples, for the spectrum task
+static uint32_t spec_power[SPEC_FFT_N / 2u];
+static uint16_t spec_skipped = 0;                                       // Spectrum runs in the suction without a clean window
+static uint8_t flow_bin = 0;                                            // Strongest az bin while the suction is open
+static uint32_t flow_power = 0;
+static ASCENT ascent;                                                   // Lift bag control in RESURFACE
+static uint32_t lift_ms_start = 0;                                      // Sol_OnMs(HAL_LIFT) at the start of the ascent
+#ifdef SD
+static char log_buf[LOG_BUF_LEN];                                       // SD text waiting for the log task
+static uint16_t log_len = 0;
+static uint32_t log_dropped = 0;                                        // Log writes lost to a full buffer
+#endif
+
+static const TRANSFER_IO run_io = { Hal_RunOpen, Hal_RunRead, Hal_RunClose, Proto_Send, BT_TxFree };
+
+/* Bluetooth command handlers, called from rx_interrupt through the dispatch table. State changes are posted
+ * to the main loop as events. */
+static void Post_Command(uint8_t cmd, uint8_t event, uint16_t arg){
+    if (!Event_Post(event, arg)){ Proto_Nak(cmd, NAK_BUSY); return; }
+    Proto_Ack(cmd);
+}
+
+static void Cmd_Ping(const uint8_t *payload, uint8_t len){
+    Proto_Ack(CMD_PING);
+}
+
+static void Cmd_Start(const uint8_t *payload, uint8_t len){
+    if (STATE != WAIT_TO_LAUNCH){ Proto_Nak(CMD_START, NAK_STATE); return; }
+    Post_Command(CMD_START, EV_START, 0);
+}
+
+static void Cmd_Depth(const uint8_t *payload, uint8_t len){
+    PROTO_DEPTH cmd;
+    cmd.depth = Proto_GetU16(payload);
+    if (STATE != WAIT_TO_LAUNCH){ Proto_Nak(CMD_DEPTH, NAK_STATE); return; }
+    if (cmd.depth == 0 || cmd.depth > MAX_DEPTH){ Proto_Nak(CMD_DEPTH, NAK_VALUE); return; }
+    Post_Command(CMD_DEPTH, EV_DEPTH, cmd.depth);   // Non-zero depth starts the launch countdown
+}
+
+static void Cmd_Reset(const uint8_t *payload, uint8_t len){
+    Post_Command(CMD_RESET, EV_RESET, 0);
+}
+
+static void Cmd_Data(const uint8_t *payload, uint8_t len){
+    PROTO_DATA_REQ cmd;
+    cmd.run = Proto_GetU16(payload);
+    cmd.offset = Proto_GetU32(payload + 2);
+    if (STATE != TRANSMIT){ Proto_Nak(CMD_DATA, NAK_STATE); return; }
+    dataflag = 1;
+    Transfer_Request(cmd.run, cmd.offset);
+    Proto_Ack(CMD_DATA);
+}
+
+static void Cmd_DataAck(const uint8_t *payload, uint8_t len){
+    PROTO_DATA_ACK cmd;
+    cmd.next = Proto_GetU32(payload);
+    Transfer_Ack(cmd.next);                     // No reply, acks stream alongside the chunks
+}
+
+static void Cmd_Telemetry(const uint8_t *payload, uint8_t len){
+    PROTO_TELEMETRY_CFG cmd;
+    cmd.rate_hz = payload[0];
+    if (!Telemetry_SetRate(cmd.rate_hz)){ Proto_Nak(CMD_TELEMETRY, NAK_VALUE); return; }
+    Proto_Ack(CMD_TELEMETRY);
+}
+
+static void Cmd_Power(const uint8_t *payload, uint8_t len){
+    Power_Request();                            // Sent by the recorder task
+}
+
+static void Cmd_Ram(const uint8_t *payload, uint8_t len){
+    Ram_Request();                              // Sent by the recorder task
+}
+
+/* Suction profile for the next landing, only taken at the surface while the profile is not playing */
+static void Cmd_Suction(const uint8_t *payload, uint8_t len){
+    SOL_STEP steps[SOL_STEPS_MAX];
+    uint8_t i;
+    
+    if (STATE != WAIT_TO_LAUNCH){ Proto_Nak(CMD_SUCTION, NAK_STATE); return; }
+    for (i = 0; i < SOL_STEPS_MAX; i++){
+        steps[i].duty = payload[i * 3u];
+        steps[i].ms = Proto_GetU16(&payload[i * 3u + 1u]);
+        if (steps[i].duty > SOL_FULL){ Proto_Nak(CMD_SUCTION, NAK_VALUE); return; }
+    }
+    if (!Sol_ProfileMs(steps)){ Proto_Nak(CMD_SUCTION, NAK_VALUE); return; }
+    for (i = 0; i < SOL_STEPS_MAX; i++) suction[i] = steps[i];
+    Proto_Ack(CMD_SUCTION);
+}
+
+#ifdef PROFILE
+static void Cmd_Profile(const uint8_t *payload, uint8_t len){
+    PROTO_PROFILE cmd;
+    cmd.reset = payload[0];
+    Prof_Dump(cmd.reset);                       // Sent by the profile task
+    Proto_Ack(CMD_PROFILE);
+}
+#endif
+
+static const PROTO_COMMAND bt_commands[] = {
+    { CMD_PING,  0,                   Cmd_Ping  },
+    { CMD_START, 0,                   Cmd_Start },
+    { CMD_DEPTH, sizeof(PROTO_DEPTH), Cmd_Depth },
+    { CMD_RESET, 0,                   Cmd_Reset },
+    { CMD_DATA,     PROTO_DATA_REQ_LEN, Cmd_Data    },
+    { CMD_DATA_ACK, PROTO_DATA_ACK_LEN, Cmd_DataAck },
+    { CMD_TELEMETRY, sizeof(PROTO_TELEMETRY_CFG), Cmd_Telemetry },
+    { CMD_POWER,    0,                  Cmd_Power   },
+    { CMD_RAM,      0,                  Cmd_Ram     },
+    { CMD_SUCTION,  PROTO_SUCTION_LEN,  Cmd_Suction },
+#ifdef PROFILE
+    { CMD_PROFILE,  sizeof(PROTO_PROFILE), Cmd_Profile },
+#endif
+};
+
+/* Show a state banner, the LCD task puts it on the display */
+static void Banner(const char *text){
+    Display_Row(0, text);
+    Display_Row(1, 0);
+}
+
+/* Second line under the current banner */
+static void Banner2(const char *text){
+    Display_Row(1, text);
+}
+
+#ifdef SD
+/* Queue text for the SD log, the log task writes it out */
+static void Log_Write(const char *text, uint16_t len){
+    if (log_len + len > LOG_BUF_LEN){
+        log_dropped++;
+        return;
+    }
+    memcpy(&log_buf[log_len], text, len);
+    log_len += len;
+}
+#endif
+
+/* Log task: write queued log text to the SD card in one go */
+static void Task_Log(void){
+    #ifdef SD
+        if (log_len == 0 || !Hal_LogWrite(log_buf, log_len)) return;    // Kept while no file is open
+        log_len = 0;
+    #endif
+}
+
+/* LCD task: send the characters of the framebuffer that changed, a few at a time */
+static void Task_Lcd(void){
+    #ifdef LCD
+        Display_Flush(LCD_FLUSH_CHARS);
+    #endif
+}
+
+/* Pressure sampling, every tick in every state */
+static void Sample_Pressure(void){
+    int32_t counts;
+    
+    if(!Hal_Pressure(&counts)) return;                          // voltage conversion for pressure
+    output = counts;
+    voltage = output * (HAL_ADC_VOLTS / HAL_ADC_COUNTS);
+    if (press_id < MA_WINDOW){
+        pressure_sum += voltage;     
+    }
+    else if(press_id == MA_WINDOW){
+        pressure_sum += voltage;
+        pressure_avg = pressure_sum/MA_WINDOW;                            // compute baseline average
+    }
+    else{
+        pressure_avg = ComputeMA(pressure_avg, MA_WINDOW, voltage);
+        if (STATE == WAIT_TO_LAUNCH) surface_pressure = pressure_avg;
+        #ifdef SD
+        {
+            char sdbuf[40];
+            FMT f;
+            Fmt_Begin(&f, sdbuf, sizeof(sdbuf), &line_pressure);        // log pressure data
+            Fmt_Fixed(&f, (int32_t)(pressure_avg * 10000), 4);
+            Fmt_Template(&f, &line_pressure_sep);
+            Fmt_Int(&f, (int16)output, 0);
+            Fmt_Char(&f, '\n');
+            Log_Write(sdbuf, Fmt_Len(&f));
+        }
+        #endif
+    }
+    press_id++;
+}
+
+/* Live telemetry while at the surface */
+static void Send_Telemetry(void){
+    TELEMETRY_SAMPLE telem;
+    uint32_t latency, misses = Sched_Misses(&sched);
+    
+    if (!(STATE == WAIT_TO_LAUNCH || STATE == RESURFACE || STATE == TRANSMIT)) return;
+    if (!Telemetry_Due(clock_ms)) return;
+    latency = event_stats.latency_max;
+    telem.state = STATE;
+    telem.accel_z = imu_ma.average;
+    telem.tilt_x = (int16_t)imu_ma.xavg;
+    telem.tilt_y = (int16_t)imu_ma.yavg;
+    telem.depth_cm = DepthFromPressure(pressure_avg, surface_pressure);
+    telem.pressure_mv = (uint16_t)(pressure_avg * 1000);
+    telem.loops = runs;
+    telem.loop_max_us = (run_max > 0xFFFFu) ? 0xFFFFu : (uint16_t)run_max;
+    telem.misses = (misses > 0xFFFFu) ? 0xFFFFu : (uint16_t)misses;
+    telem.latency_max_us = (latency > 0xFFFFu) ? 0xFFFFu : (uint16_t)latency;
+    telem.ticks = tick_count;
+    telem.ticks_missed = (jitter_stats.missed > 0xFFFFu) ? 0xFFFFu : (uint16_t)jitter_stats.missed;
+    telem.interval_max_us = (jitter_stats.max_us > 0xFFFFu) ? 0xFFFFu : (uint16_t)jitter_stats.max_us;
+    Telemetry_Send(&telem);
+    runs = 0;
+    run_max = 0;
+    event_stats.latency_max = 0;
+}
+
+/* Periodic status message to the phone while waiting or transmitting */
+static void Status_Send(const EVENT *ev){
+    #ifdef BT
+        BT_Send(buf, STATE, 10, &status_first); // Here, the STATE variable only matters, rest do not matter(could be anything)
+    #endif
+}
+
+/* Guards for the timer events: drop expiries queued before their timer was stopped or restarted */
+static uint8_t Countdown_Current(const EVENT *ev){
+    return Timer_Current(TMR_LAUNCH, ev->arg);
+}
+
+static uint8_t Stage_Current(const EVENT *ev){
+    return Timer_Current(TMR_STAGE, ev->arg);
+}
+
+/* WAIT_TO_LAUNCH: waiting for start command and depth */
+static void Wait_Entry(const EVENT *ev){       // Only reached through a reset
+    imu_ma.id = 1;                         // Interrupt count.
+    data_time = 0;                         // data point num
+    imu_ma.sum = 0;                        // Sum of accelerometer values. 
+    imu_ma.average = 0;                    // Moving average variable.
+    imu_ma.xavg = 0; imu_ma.yavg = 0;      // Gyro average variables
+    PANIC_flag = 0;                        // flag indicating water is present in housing.
+    tilted = 0;
+    //bool first_test = 1;                 // flag indicating first test(longer countdown)
+    depth = 0; countdown = 0;              // Current desired depth, variable for counting seconds 
+    dataflag = 0;                          // data flag 
+    pulse = 0;
+    Timer_Stop(TMR_LAUNCH);
+    Banner("STATE: WAIT");
+}
+
+static void Wait_Start(const EVENT *ev){
+    dataflag = 1;
+}
+
+static void Wait_Depth(const EVENT *ev){
+    depth = ev->arg;
+    countdown = 0;
+    Timer_Every(TMR_LAUNCH, 1000u, EV_COUNTDOWN);  // Once depth has been entered, count down into descending
+}
+
+static void Wait_Status(const EVENT *ev){
+    if (!dataflag) Status_Send(ev);
+}
+
+static void Wait_Countdown(const EVENT *ev){
+    countdown++;
+    #ifdef BT
+    {
+        FMT f;
+        Fmt_Start(&f, buf, sizeof(buf));
+        Fmt_Char(&f, '\n');
+        Fmt_Int(&f, LAUNCH_SECONDS - countdown, 0);
+        Fmt_Template(&f, &line_countdown);
+        Proto_SendText(buf);
+    }
+    #endif
+    if (countdown == LAUNCH_SECONDS){
+        Timer_Stop(TMR_LAUNCH);
+        Fsm_Raise(&dive, EV_LAUNCH, 0);
+    }
+}
+
+static void Launch(const EVENT *ev){
+    Jitter_Reset();                             // Sample tick counts cover this dive
+    descent_time = (((depth / 13) + 3) * 2 * 500);
+    /* descent time takes about 2~3 seconds to go 13 feet, add 3 for extra 10m of leeway, x500 for
+     * number of ISR calls to get 1 second */ 
+}
+
+/* DESCENDING: watch for the bottom */
+static void Descend_Entry(const EVENT *ev){
+    Banner("STATE: DESCENT");
+    #ifdef BT
+        Proto_SendText(STATE_DESCENDING);
+    #endif
+    countdown = 0; 
+    Spec_Clear(&imu_win);
+}
+
+static void Descend_Tick(const EVENT *ev){
+    PROF_BEGIN(PROF_DESCEND);
+    uint8_t found = Detect_Ma(&imu_ma, az, gx, gy);
+    
+    if (found == DETECT_TILT){
+        Fsm_Raise(&dive, EV_TILT, 0);                       // start lift bag
+    }
+    else if(found == DETECT_BOTTOM){                        
+        Fsm_Raise(&dive, EV_BOTTOM, 0);                     //Switch to LANDED state 
+    }
+    /* if max time allowed for descent has been reached, resurface */
+    else if(data_time >= descent_time ){                    // variable descent time
+        Fsm_Raise(&dive, EV_TIMEOUT, 0);
+    }
+    PROF_END(PROF_DESCEND);
+}
+
+/* LANDED: settle, run the suction, then release */
+static void Landed_Entry(const EVENT *ev){
+    Banner("STATE: LANDED");
+    #ifdef SD
+        Log_Write(line_landed.text, line_landed.len);
+        Log_Write(line_vacuum.text, line_vacuum.len);
+    #endif
+    imu_ma.id=0;                                            //reset sample counter
+    data_time = 0;
+    imu_ma.sum = 0;
+    imu_ma.average = 0; 
+    pulse = 0;
+    Suc_Reset(&suc);
+    Timer_Start(TMR_STAGE, SETTLE_SECONDS * 1000u, EV_STAGE);   // Delay at bottom
+}
+
+static void Landed_Exit(const EVENT *ev){
+    Timer_Stop(TMR_STAGE);
+    Sol_Set(HAL_SUCTION, 0);                                        // Suction off however the state is left
+}
+
+/* Close the suction valve and wait before resurfacing. result is how the suction ended, for the log. */
+static void Suction_End(const char *result, uint32_t wait_ms){
+    pulse = 2;
+    #ifdef SD
+    {
+        char line[64];
+        FMT f;
+        Fmt_Start(&f, line, sizeof(line));
+        FMT_LIT(&f, "suction ");
+        Fmt_Str(&f, result);
+        FMT_LIT(&f, " ms ");
+        Fmt_Uint(&f, suc.ms, 0, ' ');
+        FMT_LIT(&f, " peak ");
+        Fmt_Uint(&f, suc.peak, 0, ' ');
+        FMT_LIT(&f, " settled ");
+        Fmt_Uint(&f, suc.settled, 0, ' ');
+        FMT_LIT(&f, " flow_hz ");
+        Fmt_Uint(&f, flow_bin * SPEC_SAMPLE_HZ / SPEC_FFT_N, 0, ' ');
+        FMT_LIT(&f, " held ");
+        Fmt_Uint(&f, imu_win.held, 0, ' ');
+        FMT_LIT(&f, " skipped ");
+        Fmt_Uint(&f, spec_skipped, 0, ' ');
+        Fmt_Char(&f, '\n');
+        Log_Write(line, Fmt_Len(&f));
+    }
+    #endif
+    Timer_Start(TMR_STAGE, wait_ms + RELEASE_SECONDS * 1000u, EV_STAGE);  // Delay for 3 seconds then resurface
+}
+
+static void Landed_Tick(const EVENT *ev){
+    Detect_MaGyro(&imu_ma, gx, gy);
+    if (Suc_Sample(&suc, az) == SUC_SETTLED && pulse == 1){    // Flow has stopped, no point holding on
+        Sol_Set(HAL_SUCTION, 0);
+        Suction_End("settled", 0);
+    }
+//    if (countdown > 7 && pulse == 0){       // Allow for device to settle
+//        if (abs((int)imu_ma.xavg) > DEGREES_20 || abs((int)imu_ma.yavg) > DEGREES_20){ // If tilting, send back up
+//            secs_for_tilt++;
+//            if (secs_for_tilt > 750) {
+//                secs_for_tilt = 0;
+//                Fsm_Raise(&dive, EV_TILT, 0);
+//            }
+//        }
+//    }
+}
+
+/* Settle, suction, release. The suction stage wakes SUC_LEAD_MS before the profile ends to extend it while
+ * water is still flowing, see suction.h. */
+static void Landed_Stage(const EVENT *ev){
+    if (pulse == 0) {                       // Settled
+        pulse = 1;                          // next stage of the state
+        Sol_Profile(HAL_SUCTION, suction);          // run solenoid 1 through the suction profile
+        Suc_Open(&suc);
+        flow_bin = 0;
+        flow_power = 0;
+        spec_skipped = 0;
+        suction_ms = Sol_ProfileMs(suction);
+        Timer_Start(TMR_STAGE, (suction_ms > SUC_LEAD_MS) ? suction_ms - SUC_LEAD_MS : 1u, EV_STAGE);
+    } 
+    else if (pulse == 1){                   // Near the end of the profile
+        if (Suc_Flowing(&suc) && suction_ms + SUC_EXTEND_MS <= SUC_MAX_MS && Sol_Extend(HAL_SUCTION, SUC_EXTEND_MS)){
+            suction_ms += SUC_EXTEND_MS;
+            Timer_Start(TMR_STAGE, SUC_EXTEND_MS, EV_STAGE);
+            return;
+        }
+        Suction_End(Suc_Flowing(&suc) ? "flowing" : "profile", Sol_ProfileLeft(HAL_SUCTION));  // solenoid 1 closes at the end of the profile
+    }
+    else {
+        Fsm_Raise(&dive, EV_RISE, 0);
+    }
+}
+
+static void Tilted(const EVENT *ev){
+    tilted = 1;
+}
+
+/* RESURFACE: inflate the lift bag under closed loop control, see ascent.h */
+static void Water(const EVENT *ev){
+    PANIC_flag = 1;
+    Banner2("WATER DETECTED");              // Display that moisture sensor triggered
+}
+
+static void Resurface_Entry(const EVENT *ev){
+    Banner("STATE: RESURFACE");
+    if (PANIC_flag) Water(ev);
+    else if (tilted) Banner2("Tilted");
+    #ifdef SD
+        Log_Write(line_resurface.text, line_resurface.len);
+    #endif
+    imu_ma.id=0;                            //reset sample counter
+    data_time = 0;
+    imu_ma.sum = 0;                         //reset sum 
+    imu_ma.average = 0;
+    lift_ms_start = Sol_OnMs(HAL_LIFT);
+    Ascent_Start(&ascent, DepthFromPressure(pressure_avg, surface_pressure));
+    Timer_Every(TMR_STAGE, ASC_PERIOD_MS, EV_STAGE);
+}
+
+static void Resurface_Exit(const EVENT *ev){
+    Timer_Stop(TMR_STAGE);
+    Sol_Set(HAL_LIFT, 0);
+}
+
+/* Control step: valve duty from the ascent rate, until the pressure sensor says we are at the surface */
+static void Resurface_Stage(const EVENT *ev){
+    uint8_t result = Ascent_Step(&ascent, DepthFromPressure(pressure_avg, surface_pressure));
+    
+    Sol_Set(HAL_LIFT, ascent.duty);
+    if (result == ASC_RISING) return;
+    #ifdef SD
+    {
+        char line[80];
+        FMT f;
+        Fmt_Start(&f, line, sizeof(line));
+        FMT_LIT(&f, "ascent ");
+        Fmt_Str(&f, (result == ASC_SURFACED) ? "surfaced" : "timeout");
+        FMT_LIT(&f, " from_cm ");
+        Fmt_Int(&f, ascent.start_cm, 0);
+        FMT_LIT(&f, " ms ");
+        Fmt_Uint(&f, ascent.ms, 0, ' ');
+        FMT_LIT(&f, " lift_ms ");
+        Fmt_Uint(&f, Sol_OnMs(HAL_LIFT) - lift_ms_start, 0, ' ');
+        FMT_LIT(&f, " rate_max ");
+        Fmt_Int(&f, ascent.rate_max, 0);
+        Fmt_Char(&f, '\n');
+        Log_Write(line, Fmt_Len(&f));
+    }
+    #endif
+    Fsm_Raise(&dive, EV_SURFACED, 0);
+}
+
+/* TRANSMIT: serve the logs */
+static void Transmit_Entry(const EVENT *ev){
+    status_first = 1;                           // Announce TRANSMITTING once per surfacing
+    #ifdef SD                                   //close old file, open new one
+        {
+            char line[JITTER_LINE_LEN];
+            Task_Log();
+            Hal_LogRewrite(0, line, Jitter_Header(line));   // How the dive's sampling kept up, in the line reserved at open
+        }
+        testnum = Transfer_NextRun((uint16_t)testnum);
+        Transfer_RunName(file, (uint16_t)testnum);
+        Dive_LogOpen();
+    #endif 
+    Banner("TRANSMIT");
+    #ifdef SD
+        Log_Write(line_transmit.text, line_transmit.len);
+    #endif
+}
+
+static void Transmit_Exit(const EVENT *ev){
+    Transfer_Cancel();
+}
+
+static void Transmit_Tick(const EVENT *ev){
+    Transfer_Poll(clock_ms);                        // Stream the requested run, if any
+}
+
+/* Entry and exit actions, indexed by STATES */
+static const FSM_STATE dive_states[] = {
+    /* SYSTEM_CHECK   */ { 0,               0              },
+    /* WAIT_TO_LAUNCH */ { Wait_Entry,      0              },
+    /* DESCENDING     */ { Descend_Entry,   0              },
+    /* LANDED         */ { Landed_Entry,    Landed_Exit    },
+    /* RESURFACE      */ { Resurface_Entry, Resurface_Exit },
+    /* TRANSMIT       */ { Transmit_Entry,  Transmit_Exit  },
+    /* ERROR          */ { 0,               0              },
+};
+
+static const FSM_TRANSITION dive_table[] = {
+    /* state            event         guard  action            next */
+    { WAIT_TO_LAUNCH,   EV_START,     0,     Wait_Start,       FSM_SAME       },
+    { WAIT_TO_LAUNCH,   EV_DEPTH,     0,     Wait_Depth,       FSM_SAME       },
+    { WAIT_TO_LAUNCH,   EV_COUNTDOWN, Countdown_Current, Wait_Countdown, FSM_SAME },
+    { WAIT_TO_LAUNCH,   EV_STATUS,    0,     Wait_Status,      FSM_SAME       },
+    { WAIT_TO_LAUNCH,   EV_LAUNCH,    0,     Launch,           DESCENDING     },
+    
+    { DESCENDING,       EV_TICK,      0,     Descend_Tick,     FSM_SAME       },
+    { DESCENDING,       EV_BOTTOM,    0,     0,                LANDED         },
+    { DESCENDING,       EV_TIMEOUT,   0,     0,                RESURFACE      },
+    { DESCENDING,       EV_TILT,      0,     Tilted,           RESURFACE      },
+    
+    { LANDED,           EV_TICK,      0,     Landed_Tick,      FSM_SAME       },
+    { LANDED,           EV_STAGE, Stage_Current, Landed_Stage, FSM_SAME       },
+    { LANDED,           EV_RISE,      0,     0,                RESURFACE      },
+    { LANDED,           EV_TILT,      0,     Tilted,           RESURFACE      },
+    
+    { RESURFACE,        EV_STAGE, Stage_Current, Resurface_Stage, FSM_SAME    },
+    { RESURFACE,        EV_SURFACED,  0,     0,                TRANSMIT       },
+    { RESURFACE,        EV_WATER,     0,     Water,            FSM_SAME       },
+    
+    { TRANSMIT,         EV_TICK,      0,     Transmit_Tick,    FSM_SAME       },
+    { TRANSMIT,         EV_STATUS,    0,     Status_Send,      FSM_SAME       },
+    
+    { FSM_ANY,          EV_WATER,     0,     Water,            RESURFACE      },
+    { FSM_ANY,          EV_RESET,     0,     0,                WAIT_TO_LAUNCH },
+};
+
+/* Sample task: read the sensors the current state needs */
+static void Task_Sample(void){
+    uint32_t elapsed = tick_count - ticks_seen;
+    HAL_IMU imu;
+    uint8_t status;
+    
+    ticks_seen += elapsed;
+    Jitter_Take(elapsed, Clock_Us());
+    if (STATE == DESCENDING || STATE == LANDED) data_time += elapsed;
+    Sample_Pressure();
+    if ((int32_t)(ticks_seen - rec_due) >= 0){
+        rec_due = ticks_seen + REC_SENSOR_TICKS;
+        Rec_Log(REC_SENSOR, dive.state, (uint16_t)az);
+        Rec_Log(REC_PRESSURE, dive.state, (uint16_t)(int16_t)output);
+    }
+    if (STATE != DESCENDING && STATE != LANDED) return;
+    
+    /* Take the result of the IMU read started last time (one sample period old) and start the next, so the
+     * task never waits on the bus */
+    status = Hal_ImuPoll(&imu);
+    if (status == HAL_IMU_DONE){
+        az = imu.az;
+        gx = imu.gx;
+        gy = imu.gy;
+        gz = imu.gz;
+    }
+    Spec_Push(&imu_win, az, gx, gy, status != HAL_IMU_DONE);  // Every period, so the window keeps the sample rate
+    if (status == HAL_IMU_PENDING) return;          // Still on the bus, keep the previous readings
+    Hal_ImuStart();
+}
+
+/* Filter task: run the state's per sample work on the latest readings */
+static void Task_Filter(void){
+    EVENT ev;
+    
+    ev.id = EV_TICK;
+    ev.arg = 0;
+    ev.stamp = Clock_Us();
+    Fsm_Dispatch(&dive, &ev);
+}
+
+/* Spectrum task: while the suction is open the strongest az bin of the IMU window is the flow tone, see
+ * spectrum.h. Nothing else reads a spectrum, so no other axis or state is worth an FFT. Tasks never preempt
+ * one another, so the window cannot change under it. A window holding readings the sample task had to repeat
+ * is skipped and counted, the steps would show as spurious tones. */
+static void Task_Spectrum(void){
+    uint32_t power;
+    uint8_t bin;
+    
+    if (STATE != LANDED || pulse != 1) return;
+    if (!Spec_Ready(&imu_win)){
+        spec_skipped++;
+        return;
+    }
+    PROF_BEGIN(PROF_SPECTRUM);
+    Spec_Fft(&imu_win, SPEC_AZ, spec_power);
+    bin = Spec_Peak(spec_power, 1u, SPEC_FFT_N / 2u - 1u, &power);
+    if (power > flow_power){
+        flow_power = power;
+        flow_bin = bin;
+    }
+    PROF_END(PROF_SPECTRUM);
+}
+
+/* Telemetry task: frames go out at the rate the host asked for */
+static void Task_Telemetry(void){
+    #ifdef BT
+        Send_Telemetry();
+    #endif
+}
+
+/* Recorder task: send the flight recorder records the last reset left behind, and the power and RAM
+ * reports CMD_POWER and CMD_RAM asked for */
+static void Task_Recorder(void){
+    Rec_Poll();
+    Power_Poll();
+    Ram_Poll();
+}
+
+#ifdef PROFILE
+/* Profile task: send the profile tables a CMD_PROFILE asked for */
+static void Task_Profile(void){
+    Prof_Poll();
+}
+#endif
+
+/* Periods, deadlines and budgets in microseconds. Sample and filter share a period and the shorter sample 
+ * deadline puts each sample ahead of the filter that uses it. */
+static SCHED_TASK tasks[] = {
+    SCHED_TASK_INIT("sample",    Task_Sample,    2000,   1000,   1500),
+    SCHED_TASK_INIT("filter",    Task_Filter,    2000,   2000,   500),
+    SCHED_TASK_INIT("log",       Task_Log,       50000,  50000,  20000),
+    SCHED_TASK_INIT("spectrum",  Task_Spectrum,  50000,  50000,  1000),
+    SCHED_TASK_INIT("lcd",       Task_Lcd,       100000, 100000, 20000),
+    SCHED_TASK_INIT("telemetry", Task_Telemetry, 20000,  20000,  2000),
+    SCHED_TASK_INIT("recorder",  Task_Recorder,  20000,  20000,  2000),
+#ifdef PROFILE
+    SCHED_TASK_INIT("profile",   Task_Profile,   20000,  20000,  2000),
+#endif
+};
+
+/* Set up the state machine and the command handlers, before the interrupts that feed them start */
+void Dive_Init(void){
+    Fsm_Init(&dive, dive_states, dive_table, sizeof(dive_table) / sizeof(dive_table[0]), WAIT_TO_LAUNCH);
+    Proto_Init(bt_commands, sizeof(bt_commands) / sizeof(bt_commands[0]));
+    Transfer_Init(&run_io);
+    Transfer_RunName(file, (uint16_t)testnum);  // Named like every later run, so CMD_DATA finds it by number
+    Display_Init();
+}
+
+/* Start the periodic tasks and the status messages, once the peripherals are up */
+void Dive_Start(void){
+    Sched_Init(&sched, tasks, sizeof(tasks) / sizeof(tasks[0]), Clock_Us, (clock_ms + 1u) * 1000u);
+    Timer_Every(TMR_STATUS, STATUS_SECONDS * 1000u, EV_STATUS);
+    Banner("PSoC 5LP: O-Vac");                  // Startup Display
+    Banner2("STATE: WAIT");
+}
+
+/* One pass of the main loop: run the next event if there is one, else a task that is due, else halt until
+ * the next interrupt (1ms at most) */
+void Dive_Loop(void){
+    EVENT ev;
+    uint32_t run_start, run;
+    
+    if (Event_Get(&ev)){
+        /* Event run time for telemetry */
+        run_start = Clock_Us();
+        PROF_BEGIN(PROF_EVENT);
+        Fsm_Dispatch(&dive, &ev);
+        PROF_END(PROF_EVENT);
+        run = Event_Since(run_start);
+        if (run > run_max) run_max = run;
+        runs++;
+        return;
+    }
+    if (Sched_Run(&sched)) return;
+    Power_Idle(dive.state);
+}
+
+/* Open the log file of run testnum, empty, and reserve its first line for the jitter stats of the dive, see
+ * jitter.h. Returns 0 if it could not be opened. */
+uint8_t Dive_LogOpen(void){
+    char line[JITTER_HEADER_LEN];
+    
+    if (!Hal_LogOpen(file, 0)) return 0;
+    memset(line, ' ', sizeof(line) - 1u);
+    line[sizeof(line) - 1u] = '\n';
+    Hal_LogWrite(line, sizeof(line));
+    return 1;
+}
+
+/* Sample_Timer tick, called from its ISR every 2ms */
+void Dive_SampleTick(void){
+    tick_count++;
+}
+
+uint8_t Dive_State(void){
+    return dive.state;
+}
+
+/* [] END OF FILE */
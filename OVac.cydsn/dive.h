@@ -0,0 +1,41 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _DIVE_H_
+#define _DIVE_H_
+
+/* Dive controller: the dive_table state machine, its actions, the Bluetooth command handlers and the
+ * periodic tasks (sample, filter, log, LCD, telemetry).
+ *
+ * Everything here reaches the hardware through hal.h, so the same file builds for the board (main.c starts
+ * the components and the ISRs) and for the host simulator (sim/sim.c feeds it a sensor trace). Either one
+ * calls Dive_Init before starting the interrupts, Dive_Start once the peripherals are up, and then
+ * Dive_Loop forever. */
+
+extern int testnum;                     // Run number of the open log file, main.c Boot_Sd sets the first
+extern char file[];                     // Open log file, Transfer_RunName of testnum, RUN_FILE_NAME_LEN
+
+void Dive_Init(void);
+
+void Dive_Start(void);
+
+void Dive_Loop(void);
+
+uint8_t Dive_LogOpen(void);
+
+void Dive_SampleTick(void);
+
+uint8_t Dive_State(void);
+
+#endif /* _DIVE_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,69 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "events.h"
+#include "clock.h"
+
+volatile EVENT_STATS event_stats;
+
+static EVENT queue[EVENT_QUEUE_LEN];
+static volatile uint8_t head = 0;           // Next slot to fill, written by Event_Post with interrupts masked
+static volatile uint8_t tail = 0;           // Next slot to read, written by Event_Get only
+
+/* Microseconds since a Clock_Us stamp */
+uint32_t Event_Since(uint32_t stamp){
+    return Clock_Us() - stamp;
+}
+
+/* Queue an event, from an ISR or the main loop. Returns 0 and counts a drop if the queue is full. */
+uint8_t Event_Post(uint8_t id, uint16_t arg){
+    uint32_t stamp = Clock_Us();
+    uint8_t h, used, intState;
+
+    intState = CyEnterCriticalSection();      // Another producer may preempt this one
+    h = head;
+    used = (uint8_t)((h - tail) & 0xFFu);
+    if (used >= EVENT_QUEUE_LEN){
+        event_stats.dropped++;
+        CyExitCriticalSection(intState);
+        return 0;
+    }
+    queue[h & EVENT_QUEUE_MASK].id = id;
+    queue[h & EVENT_QUEUE_MASK].arg = arg;
+    queue[h & EVENT_QUEUE_MASK].stamp = stamp;
+    head = h + 1u;                          // Publish only once the slot is written
+    event_stats.posted++;
+    if (used + 1u > event_stats.high_water) event_stats.high_water = used + 1u;
+    CyExitCriticalSection(intState);
+    return 1;
+}
+
+/* Take the oldest event, from the main loop. Returns 0 if the queue is empty. */
+uint8_t Event_Get(EVENT *ev){
+    uint8_t t = tail;
+    uint32_t wait;
+
+    if (t == head) return 0;
+    *ev = queue[t & EVENT_QUEUE_MASK];
+    tail = t + 1u;                          // Slot may be reused from here on
+
+    wait = Event_Since(ev->stamp);
+    if (wait > event_stats.latency_max) event_stats.latency_max = wait;
+    return 1;
+}
+
+/* Returns 1 if an event is waiting. Call with interrupts masked to check before sleeping. */
+uint8_t Event_Pending(void){
+    return tail != head;
+}
+
+/* [] END OF FILE */
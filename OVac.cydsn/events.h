@@ -0,0 +1,74 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+/* Event queue from the interrupts to the main loop.
+ *
+ * Several producers, one consumer. Event_Post is called from the countdown ISR (Timer_Tick), the Bluetooth
+ * command handlers in rx_interrupt and the moisture ISR. They all run at NVIC priority 7 today, but nothing
+ * enforces that, so Event_Post claims its slot and publishes head inside a critical section and is safe from
+ * any context. Only Event_Get writes tail, and the main loop is the only consumer; events it raises for
+ * itself go through Fsm_Raise, not this queue.
+ *
+ * Each event is stamped with Clock_Us when posted, so Event_Get can report how long it waited. */
+
+#define EVENT_QUEUE_LEN         16u         // Power of two
+#define EVENT_QUEUE_MASK        (EVENT_QUEUE_LEN - 1u)
+
+/* Events. The ISR events come first, the rest are raised by state machine actions. */
+typedef enum EVENTS{
+    EV_NONE,
+    EV_TICK,                                // Sample period, dispatched by the filter task rather than queued
+    EV_COUNTDOWN,                           // Launch countdown timer, every second
+    EV_STAGE,                               // Stage timer, the current step of a timed sequence is over
+    EV_STATUS,                              // Status timer, every STATUS_SECONDS
+    EV_WATER,                               // Moisture comparator
+    EV_START,                               // CMD_START
+    EV_DEPTH,                               // CMD_DEPTH, arg is the depth in feet
+    EV_RESET,                               // CMD_RESET
+    EV_LAUNCH,                              // Launch countdown finished
+    EV_BOTTOM,                              // Acceleration moving average crossed BOT_THRESHOLD
+    EV_TIMEOUT,                             // Descent took longer than allowed for the depth
+    EV_TILT,                                // Gyro moving average past the tilt limit
+    EV_RISE,                                // Suction cycle finished
+    EV_SURFACED,                            // Lift bag pulses finished
+    EV_COUNT
+}EVENTS;
+
+typedef struct EVENT{
+    uint8_t id;                             // EVENTS value
+    uint16_t arg;
+    uint32_t stamp;                         // Clock_Us when posted
+}EVENT;
+
+typedef struct EVENT_STATS{
+    uint32_t posted;
+    uint32_t dropped;                       // Posts refused because the queue was full
+    uint8_t high_water;                     // Most events ever queued at once
+    uint32_t latency_max;                   // Longest post to dispatch wait, microseconds
+}EVENT_STATS;
+
+extern volatile EVENT_STATS event_stats;
+
+uint8_t Event_Post(uint8_t id, uint16_t arg);
+
+uint8_t Event_Get(EVENT *ev);
+
+uint8_t Event_Pending(void);
+
+uint32_t Event_Since(uint32_t stamp);
+
+#endif /* _EVENTS_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,127 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "fmt.h"
+
+#define FMT_DIGITS_MAX          10u         // Decimal digits in a uint32_t
+
+static const char hex_digit[16] = "0123456789abcdef";
+
+/* Start an empty line in buf, which holds size characters with the terminator */
+void Fmt_Start(FMT *f, char *buf, uint16_t size){
+    f->buf = buf;
+    f->size = size;
+    f->len = 0;
+    f->over = 0;
+    if (size) buf[0] = 0;
+}
+
+/* Start a line in buf with the fixed text of t */
+void Fmt_Begin(FMT *f, char *buf, uint16_t size, const FMT_TEMPLATE *t){
+    Fmt_Start(f, buf, size);
+    Fmt_Mem(f, t->text, t->len);
+}
+
+void Fmt_Template(FMT *f, const FMT_TEMPLATE *t){
+    Fmt_Mem(f, t->text, t->len);
+}
+
+void Fmt_Mem(FMT *f, const char *s, uint16_t len){
+    uint16_t room = (f->size > f->len) ? (uint16_t)(f->size - f->len - 1u) : 0u;
+    uint16_t i;
+
+    if (len > room){
+        f->over += len - room;
+        len = room;
+    }
+    for (i = 0; i < len; i++) f->buf[f->len + i] = s[i];
+    f->len += len;
+    if (f->size) f->buf[f->len] = 0;
+}
+
+void Fmt_Char(FMT *f, char c){
+    Fmt_Mem(f, &c, 1u);
+}
+
+void Fmt_Str(FMT *f, const char *s){
+    uint16_t len = 0;
+
+    while (s[len]) len++;
+    Fmt_Mem(f, s, len);
+}
+
+/* Decimal, right aligned in width characters of pad (0 for no padding) */
+void Fmt_Uint(FMT *f, uint32_t v, uint8_t width, char pad){
+    char digits[FMT_DIGITS_MAX];
+    uint8_t n = FMT_DIGITS_MAX;
+
+    do {
+        digits[--n] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v);
+    while (width > FMT_DIGITS_MAX - n){
+        Fmt_Char(f, pad);
+        width--;
+    }
+    Fmt_Mem(f, &digits[n], FMT_DIGITS_MAX - n);
+}
+
+/* Signed decimal, right aligned in width characters of spaces */
+void Fmt_Int(FMT *f, int32_t v, uint8_t width){
+    uint32_t mag = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+    uint32_t t = mag;
+    uint8_t n = 1;
+
+    while (t >= 10u){
+        t /= 10u;
+        n++;
+    }
+    if (v < 0) n++;
+    while (width > n){
+        Fmt_Char(f, ' ');
+        width--;
+    }
+    if (v < 0) Fmt_Char(f, '-');
+    Fmt_Uint(f, mag, 0, ' ');
+}
+
+/* Fixed point: v in units of 10^-decimals, so Fmt_Fixed(f, -12345, 4) writes -1.2345 */
+void Fmt_Fixed(FMT *f, int32_t v, uint8_t decimals){
+    uint32_t mag = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+    uint32_t scale = 1;
+    uint8_t i;
+
+    for (i = 0; i < decimals; i++) scale *= 10u;
+    if (v < 0) Fmt_Char(f, '-');
+    Fmt_Uint(f, mag / scale, 0, '0');
+    if (!decimals) return;
+    Fmt_Char(f, '.');
+    Fmt_Uint(f, mag % scale, decimals, '0');
+}
+
+/* Hex, lower case, in exactly digits characters (1 to 8) */
+void Fmt_Hex(FMT *f, uint32_t v, uint8_t digits){
+    char out[8];
+    uint8_t i;
+
+    if (digits > sizeof(out)) digits = sizeof(out);
+    for (i = digits; i > 0; i--){
+        out[i - 1u] = hex_digit[v & 0xFu];
+        v >>= 4;
+    }
+    Fmt_Mem(f, out, digits);
+}
+
+uint16_t Fmt_Len(const FMT *f){
+    return f->len;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _FMT_H_
+#define _FMT_H_
+
+/* Text formatting without printf.
+ *
+ * newlib's sprintf costs a few thousand cycles per line, close to a kilobyte of stack with its float support
+ * linked in, and pulls several kilobytes of flash. The writers here append to a caller's buffer through an
+ * FMT cursor that knows the buffer size: output past the end is dropped and counted in over, and the text is
+ * always terminated, so no line can overrun its buffer. Nothing is allocated.
+ *
+ * Fixed text goes in with FMT_LIT, whose length is worked out by the compiler, so a line like
+ *   FMT_LIT(&f, "pressure: "); Fmt_Fixed(&f, volts_x10000, 4); FMT_LIT(&f, ", "); Fmt_Int(&f, counts, 0);
+ * is a handful of copies and one divide per digit.
+ *
+ * The lines written over and over (the state lines and the pressure telemetry, see functions.h) have their
+ * fixed text precomputed as FMT_TEMPLATEs, a constant string with its length, so starting one is a single
+ * copy with nothing to count. */
+
+typedef struct FMT{
+    char *buf;
+    uint16_t size;                          // Including the terminator
+    uint16_t len;
+    uint16_t over;                          // Characters dropped for lack of room
+}FMT;
+
+/* Fixed text of a common line, built at compile time with FMT_TEMPLATE_INIT */
+typedef struct FMT_TEMPLATE{
+    const char *text;
+    uint16_t len;
+}FMT_TEMPLATE;
+
+/* Append a string literal, its length known at compile time */
+#define FMT_LIT(f, lit)         Fmt_Mem((f), (lit), sizeof(lit) - 1u)
+
+#define FMT_TEMPLATE_INIT(lit)  { (lit), sizeof(lit) - 1u }
+
+void Fmt_Start(FMT *f, char *buf, uint16_t size);
+
+void Fmt_Begin(FMT *f, char *buf, uint16_t size, const FMT_TEMPLATE *t);
+
+void Fmt_Template(FMT *f, const FMT_TEMPLATE *t);
+
+void Fmt_Char(FMT *f, char c);
+
+void Fmt_Mem(FMT *f, const char *s, uint16_t len);
+
+void Fmt_Str(FMT *f, const char *s);
+
+void Fmt_Uint(FMT *f, uint32_t v, uint8_t width, char pad);
+
+void Fmt_Int(FMT *f, int32_t v, uint8_t width);
+
+void Fmt_Fixed(FMT *f, int32_t v, uint8_t decimals);
+
+void Fmt_Hex(FMT *f, uint32_t v, uint8_t digits);
+
+uint16_t Fmt_Len(const FMT *f);
+
+#endif /* _FMT_H_ */
+/* [] END OF FILE */
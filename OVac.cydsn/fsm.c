@@ -0,0 +1,71 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "fsm.h"
+#include "recorder.h"
+
+/* Start in the initial state without running its entry action */
+void Fsm_Init(FSM *fsm, const FSM_STATE *states, const FSM_TRANSITION *table, uint8_t count, uint8_t initial){
+    fsm->states = states;
+    fsm->table = table;
+    fsm->count = count;
+    fsm->state = initial;
+    fsm->raised = EV_NONE;
+    fsm->transitions = 0;
+    fsm->unhandled = 0;
+}
+
+/* Queue a follow up event from inside an action */
+void Fsm_Raise(FSM *fsm, uint8_t id, uint16_t arg){
+    fsm->raised = id;
+    fsm->raised_arg = arg;
+}
+
+static void step(FSM *fsm, const EVENT *ev){
+    const FSM_TRANSITION *t;
+    uint8_t i, from = fsm->state;
+
+    for (i = 0; i < fsm->count; i++){
+        t = &fsm->table[i];
+        if (t->event != ev->id) continue;
+        if (t->state != FSM_ANY && t->state != from) continue;
+        if (t->guard && !t->guard(ev)) continue;
+
+        if (t->next == FSM_SAME){
+            if (t->action) t->action(ev);
+            return;
+        }
+        if (fsm->states[from].exit) fsm->states[from].exit(ev);
+        if (t->action) t->action(ev);
+        fsm->state = t->next;
+        fsm->transitions++;
+        Rec_Log(REC_STATE, from, (uint16_t)(t->next | (ev->id << 8)));
+        if (fsm->states[t->next].entry) fsm->states[t->next].entry(ev);
+        return;
+    }
+    fsm->unhandled++;
+}
+
+/* Run an event, and any events its actions raise, to completion */
+void Fsm_Dispatch(FSM *fsm, const EVENT *ev){
+    EVENT follow;
+
+    step(fsm, ev);
+    while (fsm->raised != EV_NONE){
+        follow.id = fsm->raised;
+        follow.arg = fsm->raised_arg;
+        follow.stamp = ev->stamp;
+        fsm->raised = EV_NONE;
+        step(fsm, &follow);
+    }
+}
+
+/* [] END OF FILE */
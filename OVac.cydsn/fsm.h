@@ -0,0 +1,66 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include "events.h"
+
+#ifndef _FSM_H_
+#define _FSM_H_
+
+/* Table driven state machine.
+ *
+ * Each state has optional entry and exit actions. Transitions are rows of (state, event, guard, action, next)
+ * searched in order, the first row whose state and event match and whose guard passes (or has none) wins.
+ * FSM_ANY matches every state, so put state specific rows before the FSM_ANY ones. A row with next FSM_SAME
+ * only runs its action. A row with a real next state runs exit(old), the action, then entry(new), so
+ * a row back to the current state re-runs its exit and entry.
+ *
+ * Every event runs to completion. An action may raise one follow up event with Fsm_Raise; it is dispatched
+ * straight after the current one, before anything else is taken from the queue. */
+
+#define FSM_ANY                 0xFFu
+#define FSM_SAME                0xFEu
+
+typedef void (*FSM_ACTION)(const EVENT *ev);
+typedef uint8_t (*FSM_GUARD)(const EVENT *ev);
+
+typedef struct FSM_STATE{
+    FSM_ACTION entry;
+    FSM_ACTION exit;
+}FSM_STATE;
+
+typedef struct FSM_TRANSITION{
+    uint8_t state;                          // State the row applies in, or FSM_ANY
+    uint8_t event;
+    FSM_GUARD guard;                        // 0 for always
+    FSM_ACTION action;                      // 0 for none
+    uint8_t next;                           // Next state or FSM_SAME
+}FSM_TRANSITION;
+
+typedef struct FSM{
+    const FSM_STATE *states;                // Indexed by state
+    const FSM_TRANSITION *table;
+    uint8_t count;                          // Rows in table
+    volatile uint8_t state;                 // Read by the ISRs, written only by Fsm_Dispatch
+    uint8_t raised;                         // Follow up event id, EV_NONE when there is none
+    uint16_t raised_arg;
+    uint32_t transitions;
+    uint32_t unhandled;                     // Events no row matched
+}FSM;
+
+void Fsm_Init(FSM *fsm, const FSM_STATE *states, const FSM_TRANSITION *table, uint8_t count, uint8_t initial);
+
+void Fsm_Dispatch(FSM *fsm, const EVENT *ev);
+
+void Fsm_Raise(FSM *fsm, uint8_t id, uint16_t arg);
+
+#endif /* _FSM_H_ */
+/* [] END OF FILE */
@@ -14,40 +14,33 @@
 #include <math.h>
 #include <FS.h>
 #include <stdbool.h>
+#include "fmt.h"
 
 #ifndef _FUNCTIONS_H_
 #define _FUNCTIONS_H_
     
-#define COMMANDS "\ncommands: \n05,start\n" \
-                 "05,reset\n" \
-                 "04,data\n" \
-                 "05,d:###"
-    
-#define COMMANDS_LEN 46
-    
 #define STATE_WAITING "STATE: WAIT_TO_LAUNCH\n"
-#define WAITING_LEN 24
-    
-#define SEND_DEPTH "Enter desired depth:"
-#define SEND_DEPTH_LEN 20
+#define WAITING_LEN (sizeof(STATE_WAITING) - 1u)
     
 #define STATE_DESCENDING "\nSTATE: DESCENDING\n"
-#define DESCENDING_LEN 19
+#define DESCENDING_LEN (sizeof(STATE_DESCENDING) - 1u)
     
 #define STATE_LANDED "STATE: LANDED\n"
-#define LANDED_LEN 14
+#define LANDED_LEN (sizeof(STATE_LANDED) - 1u)
     
 #define STATE_VACUUM "STATE: VACUUMING\n"
-#define VACUUM_LEN 17
+#define VACUUM_LEN (sizeof(STATE_VACUUM) - 1u)
     
 #define STATE_RESURFACE "STATE: RESURFACE\n"
-#define RESURFACE_LEN 17
+#define RESURFACE_LEN (sizeof(STATE_RESURFACE) - 1u)
     
 #define STATE_TRANSMIT "STATE: TRANSMIT\n"
-#define TRANSMIT_LEN 16
+#define TRANSMIT_LEN (sizeof(STATE_TRANSMIT) - 1u)
    
 #define TRANSMITTING "Transmitting data\n"
-#define TRANSMITTING_LEN 18
+#define TRANSMITTING_LEN (sizeof(TRANSMITTING) - 1u)
+
+#define PRESSURE_CM_PER_VOLT 527.0f     // 30 psi gauge sensor over a 4V span: 21.1m / 4V. Calibrate per sensor.
     
 /*State Declarations*/
 typedef enum STATES{
@@ -60,15 +53,18 @@ typedef enum STATES{
     ERROR
 }STATES;      
     
+/* Precomputed lines, see FMT_TEMPLATE */
+extern const FMT_TEMPLATE line_landed, line_vacuum, line_resurface, line_transmit;     // State lines for the log
+extern const FMT_TEMPLATE line_pressure, line_pressure_sep;    // "pressure: " volts ", " counts, every sample
+extern const FMT_TEMPLATE line_countdown;                      // After the seconds left
+    
 void I2C_LCD_print(uint8_t row, uint8_t column, uint16_t ax, uint16_t ay,uint16_t az);
 
 float ComputeMA(float avg, int16_t n, float sample);
 
-int BT_Process(char *RxBuffer, STATES *STATE, int bytes, int *dataflag, int *reset);
-
-void BT_Send(char *RxBuffer, STATES *STATE, int lengthOfBuf, int *firstPacket);
+int16_t DepthFromPressure(float volts, float surface_volts);
 
-void uint8_to_char(uint8_t a[], char b[], int len);
+void BT_Send(char *RxBuffer, STATES STATE, int lengthOfBuf, int *firstPacket);
 
 #endif /* _FUNCTIONS_H_ */
 /* [] END OF FILE */
@@ -0,0 +1,70 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+/* Peripherals used by the dive controller (dive.c).
+ *
+ * dive.c never calls a PSoC component or emFile directly, only these functions. hal_psoc.c implements them on
+ * the board; sim/hal_sim.c implements them on a Linux host against a sensor trace, so the same state machine,
+ * filters, protocol and log code can be run there (see sim/sim.c).
+ *
+ * The Bluetooth UART, the LCD and the clock are not here: bluetooth.c, display.c and clock.h already sit on
+ * top of a handful of component calls, which the simulator provides itself. */
+
+/* Solenoids */
+#define HAL_SUCTION             0u          // Solenoid 1, leg suction
+#define HAL_LIFT                1u          // Solenoid 2, lift bag
+
+/* Hal_ImuPoll results */
+#define HAL_IMU_PENDING         0u
+#define HAL_IMU_DONE            1u
+#define HAL_IMU_ERROR           2u
+
+#define HAL_ADC_VOLTS           3.32        // Pressure ADC full scale
+#define HAL_ADC_COUNTS          4096u
+
+typedef struct HAL_IMU{
+    int16_t az;                             // Acceleration, 16384 LSB/g
+    int16_t gx, gy, gz;                     // Rotation, 131 LSB/degree/s
+}HAL_IMU;
+
+void Hal_Solenoid(uint8_t which, uint8_t on);
+
+uint8_t Hal_SolenoidOn(uint8_t which);
+
+uint8_t Hal_Pressure(int32_t *counts);
+
+uint8_t Hal_ImuStart(void);
+
+uint8_t Hal_ImuPoll(HAL_IMU *imu);
+
+/* SD log file */
+uint8_t Hal_LogOpen(const char *name, uint8_t append);
+
+uint16_t Hal_LogWrite(const void *data, uint16_t len);
+
+uint8_t Hal_LogRewrite(uint32_t offset, const void *data, uint16_t len);
+
+void Hal_LogClose(void);
+
+/* Run files for Transfer_Poll, see TRANSFER_IO */
+int32_t Hal_RunOpen(uint16_t run);
+
+uint16_t Hal_RunRead(uint32_t offset, uint8_t *buf, uint16_t len);
+
+void Hal_RunClose(void);
+
+#endif /* _HAL_H_ */
+/* [] END OF FILE */
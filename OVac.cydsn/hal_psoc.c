@@ -0,0 +1,125 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <FS.h>
+#include <mpu6050.h>
+#include "hal.h"
+#include "i2c_queue.h"
+#include "transfer.h"
+#include "profile.h"
+#include "recorder.h"
+
+static FS_FILE *log_file = 0;
+static FS_FILE *run_file = 0;               // Run being downloaded over Bluetooth
+
+static uint8_t imu_raw[10];                 // ACCEL_ZOUT, TEMP_OUT and GYRO_OUT, big endian
+static volatile uint8_t imu_done = I2CQ_ERROR;  // No read queued yet
+
+void Hal_Solenoid(uint8_t which, uint8_t on){
+    if (which == HAL_SUCTION) Solenoid_1_Write(on);
+    else Solenoid_2_Write(on);
+}
+
+uint8_t Hal_SolenoidOn(uint8_t which){
+    return (which == HAL_SUCTION) ? Solenoid_1_ReadDataReg() : Solenoid_2_ReadDataReg();
+}
+
+/* Returns 1 with the latest pressure conversion in counts, 0 if the ADC has not finished one since */
+uint8_t Hal_Pressure(int32_t *counts){
+    if (!ADC_IsEndConversion(ADC_RETURN_STATUS)) return 0;
+    *counts = ADC_GetResult32();
+    return 1;
+}
+
+/* Queue a read of the accelerometer z axis and the gyro, ahead of any LCD traffic on the bus. Returns 0 if
+ * the previous read is still on the bus or the queue is full. */
+uint8_t Hal_ImuStart(void){
+    if (imu_done == I2CQ_PENDING) return 0;
+    imu_done = I2CQ_PENDING;
+    if (I2cQ_Read(I2CQ_HIGH, MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_ZOUT_H, imu_raw, sizeof(imu_raw),
+                  &imu_done)) return 1;
+    imu_done = I2CQ_ERROR;
+    return 0;
+}
+
+/* State of the read from Hal_ImuStart, with the readings once it is done */
+uint8_t Hal_ImuPoll(HAL_IMU *imu){
+    if (imu_done != I2CQ_DONE) return (imu_done == I2CQ_PENDING) ? HAL_IMU_PENDING : HAL_IMU_ERROR;
+    imu->az = (int16_t)((imu_raw[0] << 8) | imu_raw[1]);
+    imu->gx = (int16_t)((imu_raw[4] << 8) | imu_raw[5]);
+    imu->gy = (int16_t)((imu_raw[6] << 8) | imu_raw[7]);
+    imu->gz = (int16_t)((imu_raw[8] << 8) | imu_raw[9]);
+    return HAL_IMU_DONE;
+}
+
+/* Open the log file, closing any open one. Returns 0 if it could not be opened. */
+uint8_t Hal_LogOpen(const char *name, uint8_t append){
+    Hal_LogClose();
+    log_file = FS_FOpen(name, append ? "a" : "w");
+    if (!log_file) Rec_Log(REC_SD_ERR, REC_SD_OPEN, 0);
+    return log_file != 0;
+}
+
+/* Returns the number of bytes written, 0 with no log file open */
+uint16_t Hal_LogWrite(const void *data, uint16_t len){
+    uint16_t written;
+    
+    if (!log_file) return 0;
+    PROF_BEGIN(PROF_LOG_WRITE);
+    written = (uint16_t)FS_Write(log_file, data, len);
+    PROF_END(PROF_LOG_WRITE);
+    if (written != len) Rec_Log(REC_SD_ERR, REC_SD_WRITE, len);
+    return written;
+}
+
+/* Overwrite bytes already in the log, then carry on appending at the end. Returns 0 if they did not all go. */
+uint8_t Hal_LogRewrite(uint32_t offset, const void *data, uint16_t len){
+    uint16_t written;
+    
+    if (!log_file || FS_FSeek(log_file, (I32)offset, FS_SEEK_SET)) return 0;
+    written = (uint16_t)FS_Write(log_file, data, len);
+    FS_FSeek(log_file, 0, FS_SEEK_END);
+    if (written != len) Rec_Log(REC_SD_ERR, REC_SD_WRITE, len);
+    return written == len;
+}
+
+void Hal_LogClose(void){
+    if (log_file) FS_FClose(log_file);
+    log_file = 0;
+}
+
+int32_t Hal_RunOpen(uint16_t run){
+    char name[RUN_FILE_NAME_LEN];
+    Transfer_RunName(name, run);
+    run_file = FS_FOpen(name, "r");
+    if (!run_file) return -1;
+    return (int32_t)FS_GetFileSize(run_file);
+}
+
+uint16_t Hal_RunRead(uint32_t offset, uint8_t *buf, uint16_t len){
+    if (FS_FSeek(run_file, (I32)offset, FS_SEEK_SET)) return 0;
+    return (uint16_t)FS_Read(run_file, buf, len);
+}
+
+void Hal_RunClose(void){
+    if (run_file) FS_FClose(run_file);
+    run_file = 0;
+}
+
+/* emFile's fatal error hook (FS_ConfigIO.c in the emFile sources, not part of this project), called by the
+ * debug builds of the library. The halt is left to the watchdog, with the code in the flight recorder. */
+void FS_X_Panic(int ErrorCode){
+    Rec_Log(REC_FS_PANIC, 0, (uint16_t)ErrorCode);
+    while (1);
+}
+
+/* [] END OF FILE */
@@ -13,10 +13,12 @@
 /* [] END OF FILE */
 
 #include <project.h>
+#include "i2c_queue.h"
 
 
 void I2CReadBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *value) {
 	uint8_t i=0;
+	I2cQ_Lock();							// Queued LCD transfers wait
 	I2C_Master_MasterSendStart(devAddr, I2C_Master_WRITE_XFER_MODE);
 	I2C_Master_MasterWriteByte(regAddr);
 	I2C_Master_MasterSendRestart(devAddr, I2C_Master_READ_XFER_MODE);
@@ -25,6 +27,7 @@ void I2CReadBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *val
 	}
 	*value = I2C_Master_MasterReadByte(I2C_Master_NAK_DATA);
 	I2C_Master_MasterSendStop();	
+	I2cQ_Unlock();
 }
 
 void I2CReadByte(uint8_t devAddr, uint8_t regAddr, uint8_t *value) {
@@ -45,12 +48,14 @@ void I2CReadBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t *value
 	
 void I2CWriteBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *value) {
 	uint8_t i=0;
+	I2cQ_Lock();
 	I2C_Master_MasterSendStart(devAddr, I2C_Master_WRITE_XFER_MODE);
 	I2C_Master_MasterWriteByte(regAddr);
 	while (i++ < length) {
 		I2C_Master_MasterWriteByte(*value++);
 	}
 	I2C_Master_MasterSendStop();	
+	I2cQ_Unlock();
 }
 
 void I2CWriteByte(uint8_t devAddr, uint8_t regAddr, uint8_t value) {
@@ -77,6 +82,7 @@ void I2CWriteBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t value
 
 void I2CWriteWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *value) {
 	uint8_t i=0;
+	I2cQ_Lock();
 	I2C_Master_MasterSendStart(devAddr, I2C_Master_WRITE_XFER_MODE);
 	I2C_Master_MasterWriteByte(regAddr);
 	while (i++ < length) {
@@ -84,6 +90,7 @@ void I2CWriteWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *v
 		I2C_Master_MasterWriteByte((uint8_t)*value++);
 	}
 	I2C_Master_MasterSendStop();		
+	I2cQ_Unlock();
 }
 
 void I2CWriteWord(uint8_t devAddr, uint8_t regAddr, uint16_t value) {
@@ -0,0 +1,180 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <string.h>
+#include "i2c_queue.h"
+#include "recorder.h"
+
+/* Bus states */
+#define BUS_IDLE        0u
+#define BUS_WRITE       1u
+#define BUS_READ        2u
+
+volatile I2CQ_STATS i2cq_stats;
+
+static I2CQ_JOB queue[I2CQ_PRIORITIES][I2CQ_LEN];
+static volatile uint8_t head[I2CQ_PRIORITIES], tail[I2CQ_PRIORITIES];
+static I2CQ_JOB *active = 0;                // Transaction on the bus, still counted as queued
+static uint8_t active_prio;
+static volatile uint8_t bus = BUS_IDLE;
+static volatile uint8_t locked = 0;         // Blocking users holding the bus
+
+static void finish(uint8_t result){
+    if (active->done) *active->done = result;
+    tail[active_prio]++;                    // Only now may a submission reuse the slot
+    active = 0;
+    bus = BUS_IDLE;
+}
+
+static uint8_t launch(void){
+    I2C_Master_MasterClearStatus();
+    if (active->wr_len){
+        bus = BUS_WRITE;
+        return I2C_Master_MasterWriteBuf(active->addr, active->wr, active->wr_len,
+                                         active->rd_len ? I2C_Master_MODE_NO_STOP : I2C_Master_MODE_COMPLETE_XFER);
+    }
+    bus = BUS_READ;
+    return I2C_Master_MasterReadBuf(active->addr, active->rd, active->rd_len, I2C_Master_MODE_COMPLETE_XFER);
+}
+
+/* Start the next transaction if the bus is free. Interrupts must be masked or this must be an ISR, so it only
+ * tries once rather than spinning while the previous stop clears. */
+static void start_next(void){
+    uint8_t p;
+
+    if (bus != BUS_IDLE || locked) return;
+    for (p = 0; p < I2CQ_PRIORITIES; p++){
+        if (head[p] != tail[p]) break;
+    }
+    if (p == I2CQ_PRIORITIES) return;
+
+    active = &queue[p][tail[p] & I2CQ_MASK];
+    active_prio = p;
+    if (launch() == I2C_Master_MSTR_NO_ERROR){
+        i2cq_stats.jobs[p]++;
+        if (p == I2CQ_HIGH && head[I2CQ_LOW] != tail[I2CQ_LOW]) i2cq_stats.overtakes++;   // IMU ahead of the LCD
+        return;
+    }
+    i2cq_stats.deferred++;
+    active = 0;                             // Bus still busy, I2cQ_Service tries again within 1ms
+    bus = BUS_IDLE;
+}
+
+/* I2C_Master interrupt exit: move the transaction on, and start the next one once it is over */
+void I2C_Master_ISR_ExitCallback(void){
+    uint8_t status;
+
+    if (bus == BUS_IDLE) return;            // A blocking user's transfer, or nothing queued
+    status = I2C_Master_MasterStatus();
+    if (status & I2C_Master_MSTAT_ERR_XFER){
+        i2cq_stats.errors++;                // The component has already sent the stop
+        Rec_Log(REC_I2C_ERR, active->addr, status);
+        finish(I2CQ_ERROR);
+    } else if (bus == BUS_WRITE && (status & I2C_Master_MSTAT_WR_CMPLT)){
+        if (!active->rd_len){
+            finish(I2CQ_DONE);
+        } else {
+            bus = BUS_READ;
+            I2C_Master_MasterClearStatus();
+            if (I2C_Master_MasterReadBuf(active->addr, active->rd, active->rd_len, I2C_Master_MODE_REPEAT_START)
+                == I2C_Master_MSTR_NO_ERROR) return;
+            i2cq_stats.errors++;
+            Rec_Log(REC_I2C_ERR, active->addr, status);
+            finish(I2CQ_ERROR);
+        }
+    } else if (bus == BUS_READ && (status & I2C_Master_MSTAT_RD_CMPLT)){
+        finish(I2CQ_DONE);
+    } else {
+        return;                             // Mid transfer
+    }
+    start_next();
+}
+
+static uint8_t submit(uint8_t prio, uint8_t addr, const uint8_t *data, uint8_t wr_len, uint8_t *rd,
+                      uint8_t rd_len, volatile uint8_t *done){
+    I2CQ_JOB *job;
+    uint8_t s;
+
+    if (prio >= I2CQ_PRIORITIES || wr_len > I2CQ_DATA_MAX) return 0;
+    s = CyEnterCriticalSection();
+    if ((uint8_t)(head[prio] - tail[prio]) >= I2CQ_LEN){
+        i2cq_stats.full[prio]++;
+        CyExitCriticalSection(s);
+        return 0;
+    }
+    job = &queue[prio][head[prio] & I2CQ_MASK];
+    job->addr = addr;
+    job->wr_len = wr_len;
+    memcpy(job->wr, data, wr_len);
+    job->rd = rd;
+    job->rd_len = rd_len;
+    job->done = done;
+    if (done) *done = I2CQ_PENDING;
+    head[prio]++;
+    start_next();
+    CyExitCriticalSection(s);
+    return 1;
+}
+
+/* Queue a write of len bytes. Returns 0 if the queue is full. */
+uint8_t I2cQ_Write(uint8_t prio, uint8_t addr, const uint8_t *data, uint8_t len, volatile uint8_t *done){
+    return submit(prio, addr, data, len, 0, 0, done);
+}
+
+/* Queue a register read: write reg, then read len bytes into buf. buf must stay valid until done. */
+uint8_t I2cQ_Read(uint8_t prio, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len, volatile uint8_t *done){
+    return submit(prio, addr, &reg, 1, buf, len, done);
+}
+
+/* Restart the queue if a start found the bus busy. Called from the 1ms countdown ISR. */
+void I2cQ_Service(void){
+    start_next();
+}
+
+/* Transactions that can still be queued at prio */
+uint8_t I2cQ_Free(uint8_t prio){
+    if (prio >= I2CQ_PRIORITIES) return 0;
+    return (uint8_t)(I2CQ_LEN - (uint8_t)(head[prio] - tail[prio]));
+}
+
+/* Returns 1 when nothing is queued or on the bus */
+uint8_t I2cQ_Idle(void){
+    uint8_t p;
+
+    if (bus != BUS_IDLE) return 0;
+    for (p = 0; p < I2CQ_PRIORITIES; p++){
+        if (head[p] != tail[p]) return 0;
+    }
+    return 1;
+}
+
+/* Wait for every queued transaction to finish */
+void I2cQ_Drain(void){
+    while (!I2cQ_Idle());
+}
+
+/* Take the bus for blocking transfers: wait out the transaction in flight and hold the queue */
+void I2cQ_Lock(void){
+    uint8_t s = CyEnterCriticalSection();
+    locked++;
+    CyExitCriticalSection(s);
+    while (bus != BUS_IDLE);
+}
+
+void I2cQ_Unlock(void){
+    uint8_t s = CyEnterCriticalSection();
+    if (locked) locked--;
+    start_next();
+    CyExitCriticalSection(s);
+}
+
+/* [] END OF FILE */
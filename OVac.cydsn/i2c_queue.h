@@ -0,0 +1,80 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _I2C_QUEUE_H_
+#define _I2C_QUEUE_H_
+
+/* Prioritized, interrupt driven transaction queue for I2C_Master.
+ *
+ * The MPU6050 and the LCD expander share the bus. Transactions are queued at high (IMU) or low (LCD) priority
+ * and run back to back by the I2C_Master interrupt through its exit callback, using the component's buffered
+ * MasterWriteBuf/MasterReadBuf. A transaction is never cut short, but whenever the bus frees up a queued
+ * high priority transaction goes before any low priority one, so the IMU waits for at most the one LCD
+ * transaction already on the bus. The LCD driver keeps its transactions short for that reason.
+ *
+ * Starts are made from interrupt context, so each is tried once: a start that finds the bus still busy with
+ * the previous stop is left to I2cQ_Service, which the 1ms countdown ISR calls.
+ *
+ * The MPU6050 driver's blocking register functions (i2cFunctions.c) take the bus with I2cQ_Lock, which waits
+ * for the transaction in flight to finish and holds the queue until I2cQ_Unlock. */
+
+#define I2CQ_HIGH               0u
+#define I2CQ_LOW                1u
+#define I2CQ_PRIORITIES         2u
+
+#define I2CQ_LEN                16u         // Transactions queued per priority, power of two
+#define I2CQ_MASK               (I2CQ_LEN - 1u)
+#define I2CQ_DATA_MAX           16u         // Write bytes copied into a transaction
+
+/* Completion flag values */
+#define I2CQ_PENDING            0u
+#define I2CQ_DONE               1u
+#define I2CQ_ERROR              2u
+
+typedef struct I2CQ_JOB{
+    uint8_t addr;
+    uint8_t wr_len;
+    uint8_t wr[I2CQ_DATA_MAX];
+    uint8_t rd_len;                         // Bytes read after the write, with a repeated start
+    uint8_t *rd;
+    volatile uint8_t *done;                 // Set to I2CQ_DONE or I2CQ_ERROR on completion, may be 0
+}I2CQ_JOB;
+
+typedef struct I2CQ_STATS{
+    uint32_t jobs[I2CQ_PRIORITIES];         // Transactions started
+    uint32_t full[I2CQ_PRIORITIES];         // Submissions refused, queue full
+    uint32_t errors;                        // Transactions ended by NAK, lost arbitration or bus error
+    uint32_t overtakes;                     // High priority transactions started ahead of queued low ones
+    uint32_t deferred;                      // Starts that found the bus busy, left to I2cQ_Service
+}I2CQ_STATS;
+
+extern volatile I2CQ_STATS i2cq_stats;
+
+uint8_t I2cQ_Write(uint8_t prio, uint8_t addr, const uint8_t *data, uint8_t len, volatile uint8_t *done);
+
+uint8_t I2cQ_Read(uint8_t prio, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len, volatile uint8_t *done);
+
+uint8_t I2cQ_Free(uint8_t prio);
+
+uint8_t I2cQ_Idle(void);
+
+void I2cQ_Drain(void);
+
+void I2cQ_Service(void);
+
+void I2cQ_Lock(void);
+
+void I2cQ_Unlock(void);
+
+#endif /* _I2C_QUEUE_H_ */
+/* [] END OF FILE */
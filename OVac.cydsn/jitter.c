@@ -0,0 +1,77 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "jitter.h"
+#include "fmt.h"
+
+JITTER_STATS jitter_stats;
+
+void Jitter_Reset(void){
+    memset(&jitter_stats, 0, sizeof(jitter_stats));
+}
+
+/* Sample task run that took ticks new ticks at now_us. The first run after a reset only sets the start. */
+void Jitter_Take(uint32_t ticks, uint32_t now_us){
+    JITTER_STATS *j = &jitter_stats;
+    uint32_t interval, bin;
+
+    if (ticks == 0) return;                 // Ran ahead of the timer, nothing taken
+    if (j->seq){
+        interval = now_us - j->last_us;
+        bin = interval / JITTER_BIN_US;
+        j->hist[bin < JITTER_BINS ? bin : JITTER_BINS - 1u]++;
+        if (interval > j->max_us) j->max_us = interval;
+        j->missed += ticks - 1u;
+    }
+    j->seq += ticks;
+    j->runs++;
+    j->last_us = now_us;
+}
+
+/* One text line for the log: "ticks <seq> runs <n> missed <n> max_us <us> hist <bin 0> ... <bin 15>\n".
+ * out holds JITTER_LINE_LEN. Returns the length. */
+uint16_t Jitter_Format(char *out){
+    const JITTER_STATS *j = &jitter_stats;
+    FMT f;
+    uint8_t i;
+
+    Fmt_Start(&f, out, JITTER_LINE_LEN);
+    FMT_LIT(&f, "ticks ");
+    Fmt_Uint(&f, j->seq, 0, ' ');
+    FMT_LIT(&f, " runs ");
+    Fmt_Uint(&f, j->runs, 0, ' ');
+    FMT_LIT(&f, " missed ");
+    Fmt_Uint(&f, j->missed, 0, ' ');
+    FMT_LIT(&f, " max_us ");
+    Fmt_Uint(&f, j->max_us, 0, ' ');
+    FMT_LIT(&f, " hist");
+    for (i = 0; i < JITTER_BINS; i++){
+        Fmt_Char(&f, ' ');
+        Fmt_Uint(&f, j->hist[i], 0, ' ');
+    }
+    Fmt_Char(&f, '\n');
+    if (f.over) out[f.len - 1u] = '\n';      // Cut short, still one line
+    return Fmt_Len(&f);
+}
+
+/* Jitter_Format padded with spaces to JITTER_HEADER_LEN, so it fits the line reserved at the top of the log.
+ * out holds JITTER_LINE_LEN. Returns JITTER_HEADER_LEN. */
+uint16_t Jitter_Header(char *out){
+    uint16_t n = Jitter_Format(out);
+
+    memset(&out[n - 1u], ' ', JITTER_HEADER_LEN - n);
+    out[JITTER_HEADER_LEN - 1u] = '\n';
+    out[JITTER_HEADER_LEN] = 0;
+    return JITTER_HEADER_LEN;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,54 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _JITTER_H_
+#define _JITTER_H_
+
+/* Sample tick monitor.
+ *
+ * The Sample_Timer ISR counts ticks (tick_count); the sample task takes however many have arrived since its
+ * last run. One is on time. More means the main loop was busy for over a period and the filters, which run
+ * once per sample task, skipped samples: those are counted as missed. The time between sample task runs
+ * goes into a histogram of JITTER_BIN_US bins, so how often and how far the loop overruns can be read off
+ * without a scope. Counts start from Jitter_Reset, at each launch, so they cover one dive; they go out in
+ * telemetry and in the first line of the dive's SD log. That line is reserved blank, JITTER_HEADER_LEN wide,
+ * when the log is opened and rewritten in place with Jitter_Header when the dive surfaces, so a reader
+ * finds the stats without scanning the whole file. */
+
+#define JITTER_PERIOD_US        2000u       // Sample_Timer period
+#define JITTER_BIN_US           250u
+#define JITTER_BINS             16u         // Last bin takes every interval from 3.75ms up
+#define JITTER_LINE_LEN         160u        // Jitter_Format output, with its terminator
+#define JITTER_HEADER_LEN       (JITTER_LINE_LEN - 1u)  // Jitter_Header line, with its newline, no terminator
+
+typedef struct JITTER_STATS{
+    uint32_t seq;                           // Ticks taken since Jitter_Reset
+    uint32_t runs;                          // Sample task runs that took at least one
+    uint32_t missed;                        // Ticks taken more than one at a time
+    uint32_t max_us;                        // Longest interval between runs
+    uint32_t hist[JITTER_BINS];
+    uint32_t last_us;                       // Clock_Us of the last run
+}JITTER_STATS;
+
+extern JITTER_STATS jitter_stats;
+
+void Jitter_Reset(void);
+
+void Jitter_Take(uint32_t ticks, uint32_t now_us);
+
+uint16_t Jitter_Format(char *out);
+
+uint16_t Jitter_Header(char *out);
+
+#endif /* _JITTER_H_ */
+/* [] END OF FILE */
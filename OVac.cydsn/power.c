@@ -0,0 +1,115 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <string.h>
+#include "power.h"
+#include "events.h"
+#include "clock.h"
+#include "protocol.h"
+
+#if defined(CY_ISR_mpu_isr_H)               // MPU INT pin and its isr placed in the TopDesign
+#include <mpu6050.h>
+#endif
+
+POWER_STATS power_stats;
+
+static uint32_t last = 0;                   // Clock_Us when time was last accounted
+static POWER_STATS report;                  // power_stats when CMD_POWER came in, sent by Power_Poll
+static volatile uint8_t report_pending = 0;
+
+#if defined(CY_ISR_mpu_isr_H)
+/* Data ready from the MPU6050. Only here to wake the CPU, the sample task reads the data. */
+CY_ISR(Mpu_ISR_Handler){
+    mpu_int_ClearInterrupt();
+}
+#endif
+
+/* Clear the accounts and enable the wake sources that are not already started with their components */
+void Power_Start(void){
+    memset(&power_stats, 0, sizeof(power_stats));
+    last = Clock_Us();
+#if defined(CY_ISR_mpu_isr_H)
+    MPU6050_setIntDataReadyEnabled(1);
+    mpu_isr_StartEx(Mpu_ISR_Handler);
+#endif
+}
+
+/* Halt the CPU until the next interrupt, unless an event is already waiting. Interrupts are masked from the
+ * check to the halt so a post landing in between still wakes it: a pending interrupt ends the WFI inside
+ * CyPmAltAct even while masked, and its ISR runs as soon as the mask is lifted. The time since the last call
+ * and the time halted are both charged to state. */
+void Power_Idle(uint8_t state){
+    uint32_t start, end;
+    uint8_t s;
+
+    if (state >= POWER_STATES) state = POWER_STATES - 1u;
+
+    s = CyEnterCriticalSection();
+    start = Clock_Us();
+    end = start;
+    if (!Event_Pending()){
+        CyPmAltAct(PM_ALT_ACT_TIME_NONE, PM_ALT_ACT_SRC_NONE);
+        end = Clock_Us();
+        power_stats.asleep_us[state] += end - start;
+        power_stats.wakeups++;
+    }
+    power_stats.total_us[state] += end - last;
+    last = end;
+    CyExitCriticalSection(s);
+}
+
+static uint16_t Permille(uint64_t asleep, uint64_t total){
+    return total ? (uint16_t)((asleep * 1000u) / total) : 0u;
+}
+
+/* Share of the time spent in state that the CPU was halted, in tenths of a percent */
+uint16_t Power_AsleepPermille(uint8_t state){
+    uint64_t asleep, total;
+    uint8_t s;
+
+    if (state >= POWER_STATES) return 0;
+    s = CyEnterCriticalSection();               // Power_Idle updates both from the main loop
+    asleep = power_stats.asleep_us[state];
+    total = power_stats.total_us[state];
+    CyExitCriticalSection(s);
+
+    return Permille(asleep, total);
+}
+
+/* Take the raw counters for Power_Poll. Called from the CMD_POWER handler, which only copies: the 64 bit
+ * divides of the report are left to the main loop. Power_Idle updates the counters with interrupts masked,
+ * so the copy is consistent. A request while one is still queued is answered with the queued copy, which
+ * Power_Poll may be reading. */
+void Power_Request(void){
+    if (report_pending) return;
+    report = power_stats;
+    report_pending = 1;
+}
+
+/* Send a requested RSP_POWER, if the Bluetooth ring takes it. wakeups:u32, then per state
+ * asleep_permille:u16, seconds:u32. */
+void Power_Poll(void){
+    uint8_t out[POWER_REPORT_LEN], *p = out;
+    uint8_t i;
+
+    if (!report_pending) return;
+    Proto_PutU32(p, report.wakeups);
+    p += 4;
+    for (i = 0; i < POWER_STATES; i++){
+        Proto_PutU16(p, Permille(report.asleep_us[i], report.total_us[i]));
+        Proto_PutU32(p + 2, (uint32_t)(report.total_us[i] / 1000000u));
+        p += 6;
+    }
+    if (Proto_Send(RSP_POWER, out, sizeof(out))) report_pending = 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _POWER_H_
+#define _POWER_H_
+
+/* Low power idle for the main loop.
+ *
+ * When no event is queued and no task is released the main loop calls Power_Idle, which halts the CPU in
+ * Alternate Active mode until the next interrupt. Sleep mode is no use here: it stops BUS_CLK, and with it
+ * the UDB timers and the UART that have to wake us. In Alternate Active the clocks and peripherals keep
+ * running and any enabled interrupt restarts the CPU:
+ *   Sample_Timer       2ms sample tick
+ *   Countdown_timer    1ms clock, so an idle period never outlasts the next scheduler release
+ *   UART RX            Bluetooth commands
+ *   Comp               moisture comparator, while moisture_isr is started
+ *   MPU INT            data ready, only when an mpu_int pin with an mpu_isr is placed in the TopDesign
+ *
+ * Time is accounted to the dive state the loop was in, split into time asleep and total time, so the host can
+ * see how much of each state the CPU spent halted (CMD_POWER). The handler only copies the counters, the
+ * recorder task formats and sends the reply. */
+
+#define POWER_STATES            8u          // State values below this are accounted, STATES fits
+
+/* RSP_POWER payload: wakeups:u32, then per state asleep_permille:u16, seconds:u32 */
+#define POWER_REPORT_LEN        (4u + POWER_STATES * 6u)
+
+typedef struct POWER_STATS{
+    uint64_t asleep_us[POWER_STATES];
+    uint64_t total_us[POWER_STATES];
+    uint32_t wakeups;                       // Times Power_Idle halted the CPU
+}POWER_STATS;
+
+extern POWER_STATS power_stats;
+
+void Power_Start(void);
+
+void Power_Idle(uint8_t state);
+
+uint16_t Power_AsleepPermille(uint8_t state);
+
+void Power_Request(void);
+
+void Power_Poll(void);
+
+#endif /* _POWER_H_ */
+/* [] END OF FILE */
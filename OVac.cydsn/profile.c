@@ -0,0 +1,112 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <string.h>
+#include "profile.h"
+
+#ifdef PROFILE
+
+#include "protocol.h"
+#include "fmt.h"
+
+static const char *const probe_name[PROF_PROBES] = {
+    "sample_isr", "rx_isr", "countdown_isr", "event", "descend", "log_write", "spectrum"
+};
+
+static PROF_PROBE probes[PROF_PROBES];
+static volatile uint8_t dump_next = PROF_PROBES;    // Probe to send next, PROF_PROBES when not dumping
+static volatile uint8_t dump_reset = 0;
+
+static void Clear(void){
+    uint8_t i;
+
+    memset(probes, 0, sizeof(probes));
+    for (i = 0; i < PROF_PROBES; i++) probes[i].min = 0xFFFFFFFFu;
+}
+
+void Prof_Record(uint8_t probe, uint32_t cycles){
+    PROF_PROBE *p = &probes[probe];
+    uint8_t bin = cycles ? (uint8_t)(31 - __builtin_clz(cycles)) : 0u;
+
+    if (bin >= PROF_BINS) bin = PROF_BINS - 1u;
+    p->count++;
+    p->sum += cycles;
+    if (cycles < p->min) p->min = cycles;
+    if (cycles > p->max) p->max = cycles;
+    p->hist[bin]++;
+}
+
+/* Queue the tables for Prof_Poll. Called from the CMD_PROFILE handler. */
+void Prof_Dump(uint8_t reset){
+    dump_reset = reset;
+    dump_next = 0;
+}
+
+/* Profile task: send the next queued probe, if the Bluetooth ring takes it */
+void Prof_Poll(void){
+    char line[PROTO_TX_MAX_PAYLOAD + 1u];
+    PROF_PROBE p;
+    FMT f;
+    uint8_t i, s;
+
+    if (dump_next >= PROF_PROBES) return;
+
+    s = CyEnterCriticalSection();               // Consistent copy of a probe an ISR records into
+    p = probes[dump_next];
+    CyExitCriticalSection(s);
+
+    Fmt_Start(&f, line, sizeof(line));
+    FMT_LIT(&f, "prof ");
+    Fmt_Str(&f, probe_name[dump_next]);
+    FMT_LIT(&f, " n ");
+    Fmt_Uint(&f, p.count, 0, ' ');
+    FMT_LIT(&f, " min ");
+    Fmt_Uint(&f, p.count ? p.min : 0u, 0, ' ');
+    FMT_LIT(&f, " mean ");
+    Fmt_Uint(&f, (uint32_t)(p.count ? p.sum / p.count : 0u), 0, ' ');
+    FMT_LIT(&f, " max ");
+    Fmt_Uint(&f, p.max, 0, ' ');
+    for (i = 0; i < PROF_BINS; i++){
+        if (!p.hist[i]) continue;
+        FMT_LIT(&f, " h");
+        Fmt_Uint(&f, i, 0, ' ');
+        Fmt_Char(&f, '=');
+        Fmt_Uint(&f, p.hist[i], 0, ' ');
+    }
+    if (!Proto_SendText(line)) return;          // Ring full, try again next period
+
+    if (++dump_next < PROF_PROBES || !dump_reset) return;
+    s = CyEnterCriticalSection();
+    Clear();
+    CyExitCriticalSection(s);
+}
+
+#endif /* PROFILE */
+
+#if defined(PROFILE) || defined(BENCHMARK)
+
+#define DEMCR_TRCENA            (1u << 24)  // CYREG_CORE_DBG_EXC_MON_CTL, enables the DWT
+#define DWT_CYCCNTENA           (1u << 0)   // CYREG_DWT_CTRL
+
+/* Start the cycle counter, before the probed ISRs are started. The BENCHMARK build has no probe tables. */
+void Prof_Start(void){
+    CY_SET_REG32(CYREG_CORE_DBG_EXC_MON_CTL, CY_GET_REG32(CYREG_CORE_DBG_EXC_MON_CTL) | DEMCR_TRCENA);
+    CY_SET_REG32(CYREG_DWT_CYCLE_COUNT, 0u);
+    CY_SET_REG32(CYREG_DWT_CTRL, CY_GET_REG32(CYREG_DWT_CTRL) | DWT_CYCCNTENA);
+    #ifdef PROFILE
+        Clear();
+    #endif
+}
+
+#endif
+
+/* [] END OF FILE */
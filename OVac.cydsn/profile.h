@@ -0,0 +1,77 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include "config.h"
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+/* Cycle profiling on the Cortex-M3 DWT cycle counter (CYCCNT), which counts BUS_CLK: 24 cycles per us.
+ *
+ * PROF_BEGIN and PROF_END around a code path time each pass through it into that probe's table: count, min,
+ * max, mean and a histogram of floor(log2(cycles)). A probe is only ever recorded from one context (one ISR,
+ * or the main loop), so the tables need no locking; a main loop probe includes the time of any ISR that
+ * preempts it.
+ *
+ * Without PROFILE in config.h the macros are empty and profile.c compiles to nothing, so probes cost nothing
+ * in a flight build; the BENCHMARK build only uses Prof_Start and PROF_CYCLES (benchmark.h). With PROFILE,
+ * CMD_PROFILE queues the tables for the profile task, which sends one RSP_TEXT line per probe as the
+ * Bluetooth ring has room:
+ *   prof <name> n <count> min <cycles> mean <cycles> max <cycles> h<bin>=<count> ...
+ * where only the non-empty bins are listed and bin k holds passes of 2^k to 2^(k+1)-1 cycles. */
+
+#define PROF_BINS               24u         // Last bin takes everything from 2^23 cycles (0.35s) up
+
+/* Probes */
+#define PROF_SAMPLE_ISR         0u          // Sample_ISR_Handler
+#define PROF_RX_ISR             1u          // rx_interrupt
+#define PROF_COUNTDOWN_ISR      2u          // Countdown_ISR_Handler
+#define PROF_EVENT              3u          // One event through the dive state machine
+#define PROF_DESCEND            4u          // Descend_Tick, one DESCENDING sample
+#define PROF_LOG_WRITE          5u          // FS_Write of the SD log
+#define PROF_SPECTRUM           6u          // Spec_Fft of az in the spectrum task, while the suction is open
+#define PROF_PROBES             7u
+
+typedef struct PROF_PROBE{
+    uint32_t count;
+    uint32_t min, max;                      // Cycles
+    uint64_t sum;
+    uint32_t hist[PROF_BINS];
+}PROF_PROBE;
+
+/* CMD_PROFILE payload */
+typedef struct PROTO_PROFILE{
+    uint8_t reset;                          // Non-zero: clear the tables once they have been sent
+}PROTO_PROFILE;
+
+#if defined(PROFILE) || defined(BENCHMARK)
+    #define PROF_CYCLES()       CY_GET_REG32(CYREG_DWT_CYCLE_COUNT)
+#endif
+
+#ifdef PROFILE
+    #define PROF_BEGIN(probe)   uint32_t prof_start_##probe = PROF_CYCLES()
+    #define PROF_END(probe)     Prof_Record((probe), PROF_CYCLES() - prof_start_##probe)
+#else
+    #define PROF_BEGIN(probe)
+    #define PROF_END(probe)
+#endif
+
+void Prof_Start(void);
+
+void Prof_Record(uint8_t probe, uint32_t cycles);
+
+void Prof_Dump(uint8_t reset);
+
+void Prof_Poll(void);
+
+#endif /* _PROFILE_H_ */
+/* [] END OF FILE */
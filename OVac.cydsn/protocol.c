@@ -0,0 +1,201 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "protocol.h"
+#include "bluetooth.h"
+
+#define RX_FRAME_LEN    (PROTO_HEADER_LEN + PROTO_RX_MAX_PAYLOAD + PROTO_CRC_LEN)
+#define TX_FRAME_LEN    (PROTO_HEADER_LEN + PROTO_TX_MAX_PAYLOAD + PROTO_CRC_LEN)
+
+static const PROTO_COMMAND *cmd_table = 0;
+static uint8_t cmd_count = 0;
+
+/* Receive parser state, owned by the UART RX interrupt */
+static uint8_t rx_frame[RX_FRAME_LEN];
+static uint8_t rx_len = 0;                  // Decoded bytes so far
+static uint8_t rx_block = 0;                // Bytes left in the current COBS block
+static uint8_t rx_zero = 0;                 // A block ended and its implied zero has not been stored yet
+static uint8_t rx_bad = 0;                  // Frame already failed, drop bytes until the delimiter
+static uint16_t rx_crc = 0xFFFFu;
+
+/* Transmit encode buffer. Senders run from the main loop and from the ISRs' handlers, so it is static rather
+ * than on whichever stack the send came from, and filled and queued under one critical section, as BT_Write
+ * fills the ring. */
+static uint8_t tx_out[TX_FRAME_LEN + PROTO_COBS_OVERHEAD(TX_FRAME_LEN) + 1u];
+
+volatile PROTO_STATS proto_stats;
+
+void Proto_Init(const PROTO_COMMAND *table, uint8_t count){
+    cmd_table = table;
+    cmd_count = count;
+    rx_len = 0; rx_block = 0; rx_zero = 0; rx_bad = 0;
+    rx_crc = 0xFFFFu;
+    memset((void *)&proto_stats, 0, sizeof(proto_stats));
+}
+
+/* CRC-16/CCITT-FALSE, one byte at a time without a table */
+uint16_t Proto_Crc16(uint16_t crc, uint8_t b){
+    uint8_t x = (uint8_t)(crc >> 8) ^ b;
+    x ^= x >> 4;
+    return (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+}
+
+uint16_t Proto_GetU16(const uint8_t *p){
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+uint32_t Proto_GetU32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void Proto_PutU16(uint8_t *p, uint16_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+void Proto_PutU32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void rx_store(uint8_t b){
+    if (rx_len >= RX_FRAME_LEN){            // Never write past the frame buffer
+        proto_stats.overruns++;
+        rx_bad = 1;
+        return;
+    }
+    rx_frame[rx_len++] = b;
+    rx_crc = Proto_Crc16(rx_crc, b);
+}
+
+/* Validate a complete frame and run its handler */
+static void rx_dispatch(void){
+    uint8_t i, cmd, len;
+
+    if (rx_block != 0 || rx_len < PROTO_HEADER_LEN + PROTO_CRC_LEN){
+        proto_stats.framing_errors++;
+        return;
+    }
+    if (rx_crc != 0){                       // CRC sent MSB first leaves a zero remainder
+        proto_stats.crc_errors++;
+        return;
+    }
+    cmd = rx_frame[0];
+    len = rx_frame[1];
+    if (len != rx_len - PROTO_HEADER_LEN - PROTO_CRC_LEN){
+        proto_stats.framing_errors++;
+        return;
+    }
+
+    proto_stats.frames++;
+    for (i = 0; i < cmd_count; i++){
+        if (cmd_table[i].cmd == cmd){
+            if (cmd_table[i].payload_len != len)
+                Proto_Nak(cmd, NAK_LENGTH);
+            else
+                cmd_table[i].handler(&rx_frame[PROTO_HEADER_LEN], len);
+            return;
+        }
+    }
+    proto_stats.unknown++;
+    Proto_Nak(cmd, NAK_UNKNOWN);
+}
+
+/* Feed one received byte to the parser. Constant work per byte; a complete frame is dispatched as soon as its
+ * delimiter arrives. */
+void Proto_RxByte(uint8_t b){
+    if (b == 0){                            // Frame delimiter
+        if (!rx_bad && rx_len) rx_dispatch();
+        rx_len = 0; rx_block = 0; rx_zero = 0; rx_bad = 0;
+        rx_crc = 0xFFFFu;
+        return;
+    }
+    if (rx_bad) return;
+
+    if (rx_block == 0){                     // COBS code byte: b - 1 data bytes follow
+        if (rx_zero) rx_store(0);
+        rx_block = b - 1u;
+        rx_zero = (b != 0xFFu);
+    } else {
+        rx_store(b);
+        rx_block--;
+    }
+}
+
+/* COBS-encode cmd|len|payload|crc and queue it with a trailing delimiter. Returns 0 if the frame was dropped.
+ * The CRC is worked out with interrupts on, only the encode and the copy into the ring hold them off. */
+uint8_t Proto_Send(uint8_t cmd, const void *payload, uint8_t len){
+    const uint8_t *p = (const uint8_t *)payload;
+    uint8_t *out = tx_out;
+    uint16_t crc = 0xFFFFu;
+    uint16_t n, i, code_at = 0, o = 1;
+    uint8_t code = 1, b, queued;
+    uint8 intState;
+
+    if (len > PROTO_TX_MAX_PAYLOAD) return 0;
+
+    crc = Proto_Crc16(crc, cmd);
+    crc = Proto_Crc16(crc, len);
+    for (i = 0; i < len; i++) crc = Proto_Crc16(crc, p[i]);
+
+    n = PROTO_HEADER_LEN + len + PROTO_CRC_LEN;
+    intState = CyEnterCriticalSection();
+    for (i = 0; i < n; i++){
+        if (i == 0) b = cmd;
+        else if (i == 1) b = len;
+        else if (i < n - PROTO_CRC_LEN) b = p[i - PROTO_HEADER_LEN];
+        else if (i == n - PROTO_CRC_LEN) b = (uint8_t)(crc >> 8);
+        else b = (uint8_t)crc;
+
+        if (b == 0){
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        } else {
+            out[o++] = b;
+            if (++code == 0xFFu){
+                out[code_at] = code;
+                code_at = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_at] = code;
+    out[o++] = 0;
+    queued = BT_Write(out, o);
+    CyExitCriticalSection(intState);
+
+    return queued;
+}
+
+uint8_t Proto_SendText(const char *text){
+    size_t len = strlen(text);
+    if (len > PROTO_TX_MAX_PAYLOAD) len = PROTO_TX_MAX_PAYLOAD;
+    return Proto_Send(RSP_TEXT, text, (uint8_t)len);
+}
+
+void Proto_Ack(uint8_t cmd){
+    PROTO_ACK ack;
+    ack.cmd = cmd;
+    Proto_Send(RSP_ACK, &ack, sizeof(ack));
+}
+
+void Proto_Nak(uint8_t cmd, uint8_t reason){
+    uint8_t p[2];
+    p[0] = cmd;
+    p[1] = reason;
+    Proto_Send(RSP_NAK, p, sizeof(p));
+}
+
+/* [] END OF FILE */
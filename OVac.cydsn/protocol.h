@@ -0,0 +1,118 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _PROTOCOL_H_
+#define _PROTOCOL_H_
+
+/* Framed binary Bluetooth protocol.
+ *
+ * Frame on the wire:  COBS( cmd | len | payload[len] | crc16_hi | crc16_lo ) 0x00
+ *
+ * COBS removes every 0x00 from the frame so 0x00 only ever marks the end of a frame, which lets the receiver
+ * resynchronise on the next delimiter after any corruption. The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init
+ * 0xFFFF) over cmd, len and payload, sent most significant byte first. Multi-byte payload fields are little
+ * endian. Host to device commands are 0x01-0x7F, device to host messages are 0x80-0xFF. */
+
+#define PROTO_RX_MAX_PAYLOAD    32u         // Largest command payload accepted from the host
+#define PROTO_TX_MAX_PAYLOAD    240u        // Largest message payload sent to the host
+#define PROTO_HEADER_LEN        2u          // cmd + len
+#define PROTO_CRC_LEN           2u
+#define PROTO_COBS_OVERHEAD(n)  (((n) / 254u) + 1u)
+
+/* Host -> device commands */
+#define CMD_PING                0x01u       // no payload
+#define CMD_START               0x02u       // no payload, WAIT_TO_LAUNCH only
+#define CMD_DEPTH               0x03u       // PROTO_DEPTH, WAIT_TO_LAUNCH only
+#define CMD_RESET               0x04u       // no payload
+#define CMD_DATA                0x05u       // PROTO_DATA_REQ, TRANSMIT only, starts or resumes a run download
+#define CMD_DATA_ACK            0x06u       // PROTO_DATA_ACK, cumulative ack of downloaded bytes
+#define CMD_TELEMETRY           0x07u       // PROTO_TELEMETRY_CFG, set the live telemetry rate
+#define CMD_POWER               0x09u       // no payload, replies RSP_POWER
+#define CMD_PROFILE             0x0Au       // PROTO_PROFILE, sends the profile tables as text, see profile.h
+#define CMD_RAM                 0x0Bu       // no payload, replies with the stack and heap high water marks, see ram.h
+#define CMD_SUCTION             0x0Cu       // PROTO_SUCTION_LEN, WAIT_TO_LAUNCH only, suction profile, see solenoid.h
+
+/* Device -> host messages */
+#define RSP_ACK                 0x80u       // PROTO_ACK
+#define RSP_NAK                 0x81u       // PROTO_NAK
+#define RSP_TEXT                0x82u       // ASCII text, not NUL terminated
+#define RSP_CHUNK               0x83u       // offset:u32, data, crc16 of data
+#define RSP_DATA_END            0x84u       // size:u32, every byte of the run has been acked
+#define RSP_TELEMETRY           0x85u       // Fixed size telemetry frame, see telemetry.h
+#define RSP_POWER               0x86u       // Time asleep per state, see power.h
+
+/* NAK reasons */
+#define NAK_UNKNOWN             0x01u       // Command not in the dispatch table
+#define NAK_LENGTH              0x02u       // Payload length does not match the command
+#define NAK_STATE               0x03u       // Command not allowed in the current state
+#define NAK_VALUE               0x04u       // Payload value out of range
+#define NAK_BUSY                0x05u       // Event queue full, retry
+
+/* Typed payloads, decoded from the little endian wire format by the handlers */
+typedef struct PROTO_DEPTH{
+    uint16_t depth;                         // Target depth in feet
+}PROTO_DEPTH;
+
+typedef struct PROTO_ACK{
+    uint8_t cmd;                            // Command being acknowledged
+}PROTO_ACK;
+
+typedef struct PROTO_NAK{
+    uint8_t cmd;                            // Command being refused
+    uint8_t reason;                         // NAK_* reason
+}PROTO_NAK;
+
+/* Dispatch table entry. Handlers run in the UART RX interrupt as soon as the closing delimiter arrives, so
+ * they must only update state and queue replies. */
+typedef void (*PROTO_HANDLER)(const uint8_t *payload, uint8_t len);
+
+typedef struct PROTO_COMMAND{
+    uint8_t cmd;
+    uint8_t payload_len;                    // Exact payload length required
+    PROTO_HANDLER handler;
+}PROTO_COMMAND;
+
+typedef struct PROTO_STATS{
+    uint32_t frames;                        // Frames dispatched
+    uint32_t crc_errors;                    // Frames dropped for a bad CRC
+    uint32_t framing_errors;                // Truncated COBS blocks, short frames or bad length fields
+    uint32_t overruns;                      // Frames dropped for exceeding PROTO_RX_MAX_PAYLOAD
+    uint32_t unknown;                       // Valid frames with no table entry
+}PROTO_STATS;
+
+extern volatile PROTO_STATS proto_stats;
+
+void Proto_Init(const PROTO_COMMAND *table, uint8_t count);
+
+void Proto_RxByte(uint8_t b);
+
+uint8_t Proto_Send(uint8_t cmd, const void *payload, uint8_t len);
+
+uint8_t Proto_SendText(const char *text);
+
+void Proto_Ack(uint8_t cmd);
+
+void Proto_Nak(uint8_t cmd, uint8_t reason);
+
+uint16_t Proto_Crc16(uint16_t crc, uint8_t b);
+
+uint16_t Proto_GetU16(const uint8_t *p);
+
+uint32_t Proto_GetU32(const uint8_t *p);
+
+void Proto_PutU16(uint8_t *p, uint16_t v);
+
+void Proto_PutU32(uint8_t *p, uint32_t v);
+
+#endif /* _PROTOCOL_H_ */
+/* [] END OF FILE */
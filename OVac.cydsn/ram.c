@@ -0,0 +1,88 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "ram.h"
+#include "protocol.h"
+#include "fmt.h"
+
+/* cm3gcc.ld */
+extern uint32_t __cy_heap_start[];          // End of .bss
+extern uint32_t __cy_heap_end[];            // Bottom of the stack reservation
+extern uint32_t __cy_stack[];               // Top of SRAM
+
+extern void *_sbrk(int nbytes);             // Cm3Start.c
+
+static volatile uint8_t report_pending = 0; // Set by the CMD_RAM handler, sent by Ram_Poll
+
+/* Paint the heap and the free RAM up to just below the stack pointer. Called first thing in main, before
+ * interrupts are enabled and before anything is allocated. */
+void Ram_Paint(void){
+    volatile uint32_t here;
+    uint32_t *p = __cy_heap_start;
+    uint32_t *top = (uint32_t *)(((uintptr_t)&here - RAM_PAINT_MARGIN) & ~(uintptr_t)3u);
+    
+    while (p < top) *p++ = RAM_PAINT;
+}
+
+/* Deepest the stack has been, in bytes: the first word overwritten above the heap _sbrk has handed out */
+uint32_t Ram_Stack(void){
+    const uint32_t *p = (const uint32_t *)(((uintptr_t)_sbrk(0) + 3u) & ~(uintptr_t)3u);
+    
+    while (p < __cy_stack && *p == RAM_PAINT) p++;
+    return (uint32_t)(__cy_stack - p) * 4u;
+}
+
+/* Most of the heap has been written, in bytes. The heap can grow up to __cy_heap_end, so the scan starts
+ * there, or lower down at the deepest stack word if the stack has been past its reservation. */
+uint32_t Ram_Heap(void){
+    const uint32_t *p = __cy_stack - Ram_Stack() / 4u;
+    
+    if (p > __cy_heap_end) p = __cy_heap_end;
+    while (p > __cy_heap_start && p[-1] == RAM_PAINT) p--;
+    return (uint32_t)(p - __cy_heap_start) * 4u;
+}
+
+/* RAM still painted between the heap and the stack marks, in bytes */
+uint32_t Ram_Free(void){
+    return (uint32_t)(__cy_stack - __cy_heap_start) * 4u - Ram_Stack() - Ram_Heap();
+}
+
+/* Queue the report for Ram_Poll. Called from the CMD_RAM handler, the scans are too slow for the RX ISR. */
+void Ram_Request(void){
+    report_pending = 1;
+}
+
+/* Send a requested report, if the Bluetooth ring takes it */
+void Ram_Poll(void){
+    if (report_pending && Ram_Report()) report_pending = 0;
+}
+
+/* Send the marks as text. Returns 0 if the Bluetooth ring had no room. */
+uint8_t Ram_Report(void){
+    char line[80];
+    FMT f;
+    
+    Fmt_Start(&f, line, sizeof(line));
+    FMT_LIT(&f, "ram stack ");
+    Fmt_Uint(&f, Ram_Stack(), 0, ' ');
+    FMT_LIT(&f, " of ");
+    Fmt_Uint(&f, CYDEV_STACK_SIZE, 0, ' ');
+    FMT_LIT(&f, " heap ");
+    Fmt_Uint(&f, Ram_Heap(), 0, ' ');
+    FMT_LIT(&f, " of ");
+    Fmt_Uint(&f, CYDEV_HEAP_SIZE, 0, ' ');
+    FMT_LIT(&f, " free ");
+    Fmt_Uint(&f, Ram_Free(), 0, ' ');
+    return Proto_SendText(line);
+}
+
+/* [] END OF FILE */
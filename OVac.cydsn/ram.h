@@ -0,0 +1,49 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _RAM_H_
+#define _RAM_H_
+
+/* Stack and heap high water marks.
+ *
+ * cm3gcc.ld puts .data, .bss and the CYDEV_HEAP_SIZE heap at the bottom of SRAM and the CYDEV_STACK_SIZE
+ * main stack at the top, which every ISR shares. Nothing stops the stack growing down past its reservation
+ * into the free RAM between the two, so Ram_Paint fills everything from the heap up to the live stack with
+ * RAM_PAINT at the top of main. Ram_Stack scans up from the heap break to the deepest stack word, and
+ * Ram_Heap scans down from there (or from __cy_heap_end, the most _sbrk can reach) to the highest heap word,
+ * so neither mark takes in the other. A figure over the reservation means that side has been into RAM the
+ * linker thinks is free.
+ *
+ * CMD_RAM only queues the report, the recorder task sends it as one RSP_TEXT line:
+ *   ram stack <used> of <reserved> heap <used> of <size> free <bytes between heap and stack at the mark>
+ * The static side (.data, .bss) comes from the linker map, see tools/ram_report.py. */
+
+#define RAM_PAINT               0xC5C5C5C5u
+#define RAM_PAINT_MARGIN        64u         // Bytes below the stack pointer left alone while painting
+
+void Ram_Paint(void);
+
+uint32_t Ram_Stack(void);
+
+uint32_t Ram_Heap(void);
+
+uint32_t Ram_Free(void);
+
+void Ram_Request(void);
+
+void Ram_Poll(void);
+
+uint8_t Ram_Report(void);
+
+#endif /* _RAM_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,143 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <string.h>
+#include "recorder.h"
+#include "clock.h"
+#include "hal.h"
+#include "protocol.h"
+#include "fmt.h"
+
+#define REC_LINE_LEN            48u         // Text line with its terminator
+
+static const char *const kind_name[REC_KINDS] = {
+    "boot", "state", "sensor", "pressure", "i2c_err", "sd_err", "wdt_kick", "fs_panic"
+};
+
+CY_NOINIT static REC_RING rec;
+
+static uint32_t dump_from = 0, dump_to = 0;     // Previous boot's records, dump_from == dump_to when none
+static uint32_t dump_next = 0;                  // Next record for Rec_Poll
+static uint8_t header_sent = 1;
+static uint8_t reset_status = 0;                // CyResetStatus of this boot
+static uint16_t kicks = 0;
+
+/* Pick up the previous boot's ring, or start a new one after a power on. Called first thing in main, before
+ * interrupts are enabled. */
+void Rec_Start(void){
+    reset_status = CyResetStatus;
+    if (rec.magic != REC_MAGIC){
+        memset(&rec, 0, sizeof(rec));
+        rec.magic = REC_MAGIC;
+    } else if (rec.head != 0){
+        dump_to = rec.head;
+        dump_from = (dump_to > REC_ENTRIES) ? dump_to - REC_ENTRIES : 0u;
+        dump_next = dump_from;
+        header_sent = 0;
+    }
+    rec.boots++;
+    Rec_Log(REC_BOOT, reset_status, (uint16_t)rec.boots);
+}
+
+void Rec_Log(uint8_t kind, uint8_t a, uint16_t b){
+    REC_ENTRY *e;
+    uint8_t s = CyEnterCriticalSection();
+
+    e = &rec.entry[rec.head++ & REC_MASK];
+    e->ms = clock_ms;
+    e->kind = kind;
+    e->a = a;
+    e->b = b;
+    CyExitCriticalSection(s);
+}
+
+/* Count a watchdog kick, recording every REC_KICK_EVERY */
+void Rec_Kick(void){
+    if (++kicks % REC_KICK_EVERY == 0u) Rec_Log(REC_WDT_KICK, 0, kicks / REC_KICK_EVERY);
+}
+
+/* Oldest previous boot record from from on not yet overwritten by this boot, dump_to if there is none */
+static uint32_t first_kept(uint32_t from){
+    uint32_t head = rec.head;
+
+    if (head - from > REC_ENTRIES) from = head - REC_ENTRIES;
+    return (from < dump_to) ? from : dump_to;
+}
+
+static uint16_t format_header(char *line){
+    FMT f;
+
+    Fmt_Start(&f, line, REC_LINE_LEN);
+    FMT_LIT(&f, "rec boot ");
+    Fmt_Uint(&f, rec.boots - 1u, 0, ' ');
+    FMT_LIT(&f, " reset 0x");
+    Fmt_Hex(&f, reset_status, 2);
+    FMT_LIT(&f, " entries ");
+    Fmt_Uint(&f, dump_to - first_kept(dump_from), 0, ' ');
+    return Fmt_Len(&f);
+}
+
+static uint16_t format_entry(char *line, uint32_t i){
+    REC_ENTRY e;
+    FMT f;
+    uint8_t s = CyEnterCriticalSection();   // Consistent copy of a slot an ISR may be reusing
+
+    e = rec.entry[i & REC_MASK];
+    CyExitCriticalSection(s);
+    Fmt_Start(&f, line, REC_LINE_LEN);
+    FMT_LIT(&f, "rec ");
+    Fmt_Uint(&f, e.ms, 0, ' ');
+    Fmt_Char(&f, ' ');
+    Fmt_Str(&f, (e.kind < REC_KINDS) ? kind_name[e.kind] : "?");
+    Fmt_Char(&f, ' ');
+    Fmt_Uint(&f, e.a, 0, ' ');
+    Fmt_Char(&f, ' ');
+    Fmt_Uint(&f, e.b, 0, ' ');
+    return Fmt_Len(&f);
+}
+
+/* Write the previous boot's records to the open SD log. Returns the number written. */
+uint16_t Rec_Dump(void){
+    char line[REC_LINE_LEN];
+    uint16_t len, n = 0;
+    uint32_t i;
+
+    if (dump_from == dump_to) return 0;
+    len = format_header(line);
+    line[len++] = '\n';
+    if (!Hal_LogWrite(line, len)) return 0;
+    for (i = first_kept(dump_from); i != dump_to; i++){
+        len = format_entry(line, i);
+        line[len++] = '\n';
+        if (!Hal_LogWrite(line, len)) break;
+        n++;
+    }
+    return n;
+}
+
+/* Recorder task: send the next record of the previous boot, if the Bluetooth ring takes it */
+void Rec_Poll(void){
+    char line[REC_LINE_LEN];
+
+    if (dump_from == dump_to) return;
+    if (!header_sent){
+        format_header(line);
+        if (!Proto_SendText(line)) return;      // Ring full, try again next period
+        header_sent = 1;
+    }
+    dump_next = first_kept(dump_next);
+    if (dump_next == dump_to) return;
+    format_entry(line, dump_next);
+    if (Proto_SendText(line)) dump_next++;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,76 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _RECORDER_H_
+#define _RECORDER_H_
+
+/* Post-mortem flight recorder.
+ *
+ * A ring of REC_ENTRIES 8 byte records in the .noinit section, which the startup code neither loads nor
+ * zeroes, so whatever the firmware was doing before a watchdog, software or brown out reset is still there
+ * on the next boot. Rec_Log is a handful of stores inside a critical section and is called from ISRs as
+ * well as the main loop; it is never compiled out.
+ *
+ * Rec_Start, first thing in main, finds a ring left by the previous boot by its magic number and keeps
+ * recording after it, with a REC_BOOT record carrying CyResetStatus. Rec_Dump then writes the previous
+ * boot's records to the SD log, and the recorder task sends them over Bluetooth one RSP_TEXT line at a time:
+ *   rec boot <boots> reset <CyResetStatus> entries <n>
+ *   rec <ms> <kind> <a> <b>
+ * Records the new boot overwrote before the dump are skipped. */
+
+#define REC_ENTRIES             128u        // Power of two
+#define REC_MASK                (REC_ENTRIES - 1u)
+#define REC_MAGIC               0x4F564143u // "OVAC"
+#define REC_SENSOR_TICKS        250u        // Sample ticks between sensor summaries, 0.5s
+#define REC_KICK_EVERY          1024u       // Watchdog kicks per REC_WDT_KICK record
+
+/* Record kinds, with what a and b hold */
+#define REC_BOOT                0u          // CyResetStatus, boots
+#define REC_STATE               1u          // Old state, new state | event << 8
+#define REC_SENSOR              2u          // State, accelerometer z
+#define REC_PRESSURE            3u          // State, pressure ADC counts
+#define REC_I2C_ERR             4u          // Address, I2C_Master status
+#define REC_SD_ERR              5u          // REC_SD_OPEN or REC_SD_WRITE, bytes asked for
+#define REC_WDT_KICK            6u          // 0, kicks / REC_KICK_EVERY
+#define REC_FS_PANIC            7u          // 0, emFile error code
+#define REC_KINDS               8u
+
+#define REC_SD_OPEN             0u
+#define REC_SD_WRITE            1u
+
+typedef struct REC_ENTRY{
+    uint32_t ms;                            // clock_ms
+    uint8_t kind;
+    uint8_t a;
+    uint16_t b;
+}REC_ENTRY;
+
+typedef struct REC_RING{
+    uint32_t magic;
+    uint32_t head;                          // Records ever logged, the next goes at head & REC_MASK
+    uint32_t boots;
+    REC_ENTRY entry[REC_ENTRIES];
+}REC_RING;
+
+void Rec_Start(void);
+
+void Rec_Log(uint8_t kind, uint8_t a, uint16_t b);
+
+void Rec_Kick(void);
+
+uint16_t Rec_Dump(void);
+
+void Rec_Poll(void);
+
+#endif /* _RECORDER_H_ */
+/* [] END OF FILE */
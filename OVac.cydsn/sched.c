@@ -0,0 +1,88 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "sched.h"
+
+/* All tasks are first released at start and their counters cleared. Starting on a tick of the clock the CPU
+ * sleeps between keeps every release on a wake up. */
+void Sched_Init(SCHED *s, SCHED_TASK *tasks, uint8_t count, SCHED_CLOCK now, uint32_t start){
+    uint8_t i;
+
+    s->tasks = tasks;
+    s->count = count;
+    s->now = now;
+    for (i = 0; i < count; i++){
+        tasks[i].release = start;
+        tasks[i].runs = 0;
+        tasks[i].misses = 0;
+        tasks[i].overruns = 0;
+        tasks[i].wcet_us = 0;
+    }
+}
+
+/* Run the released task with the earliest deadline. Returns 0 if no task was released. */
+uint8_t Sched_Run(SCHED *s){
+    SCHED_TASK *t, *pick = 0;
+    uint32_t start, end, late, exec;
+    uint8_t i;
+
+    start = s->now();
+    for (i = 0; i < s->count; i++){
+        t = &s->tasks[i];
+        if ((int32_t)(start - t->release) < 0) continue;     // Not released yet
+        if (!pick || (int32_t)((t->release + t->deadline_us) - (pick->release + pick->deadline_us)) < 0){
+            pick = t;
+        }
+    }
+    if (!pick) return 0;
+
+    late = start - pick->release;
+    if (late >= pick->period_us){           // Whole periods lost, run once for the latest release only
+        pick->misses += late / pick->period_us;
+        pick->release += (late / pick->period_us) * pick->period_us;
+    }
+
+    pick->run();
+
+    end = s->now();
+    exec = end - start;
+    pick->runs++;
+    if (exec > pick->wcet_us) pick->wcet_us = exec;
+    if (exec > pick->budget_us) pick->overruns++;
+    if (end - pick->release > pick->deadline_us) pick->misses++;
+    pick->release += pick->period_us;
+    return 1;
+}
+
+/* Microseconds until the next release, 0 if a task is released already */
+uint32_t Sched_Idle(const SCHED *s){
+    uint32_t now = s->now(), idle = 0xFFFFFFFFu;
+    int32_t until;
+    uint8_t i;
+
+    for (i = 0; i < s->count; i++){
+        until = (int32_t)(s->tasks[i].release - now);
+        if (until <= 0) return 0;
+        if ((uint32_t)until < idle) idle = (uint32_t)until;
+    }
+    return idle;
+}
+
+/* Deadline misses over all tasks */
+uint32_t Sched_Misses(const SCHED *s){
+    uint32_t misses = 0;
+    uint8_t i;
+
+    for (i = 0; i < s->count; i++) misses += s->tasks[i].misses;
+    return misses;
+}
+
+/* [] END OF FILE */
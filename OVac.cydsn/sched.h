@@ -0,0 +1,65 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+/* Cooperative earliest-deadline-first scheduler for periodic tasks.
+ *
+ * A task is released every period and should finish within deadline of its release. Sched_Run runs the
+ * released task whose absolute deadline is earliest, to completion, and records its execution time. Tasks
+ * never preempt one another, so one slow task can make others late; the counters show which:
+ *   misses    releases that finished after their deadline, or were skipped because the task was more than a
+ *             whole period late
+ *   overruns  runs that took longer than the task's budget
+ *   wcet_us   longest run seen
+ *
+ * Time comes from the clock function handed to Sched_Init, in microseconds, wrapping at 2^32. On target that
+ * is Clock_Us; on a host it can be a virtual clock the test advances itself, which makes the scheduling
+ * deterministic (sim/test_sched.c). Nothing here touches hardware. */
+
+typedef uint32_t (*SCHED_CLOCK)(void);
+
+typedef struct SCHED_TASK{
+    const char *name;
+    void (*run)(void);
+    uint32_t period_us;
+    uint32_t deadline_us;                   // Relative to each release, at most period_us
+    uint32_t budget_us;                     // Expected worst case run time
+    uint32_t release;                       // Next release, absolute
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t overruns;
+    uint32_t wcet_us;
+}SCHED_TASK;
+
+typedef struct SCHED{
+    SCHED_TASK *tasks;
+    uint8_t count;
+    SCHED_CLOCK now;
+}SCHED;
+
+/* Task table entry, the remaining fields start at zero */
+#define SCHED_TASK_INIT(name, run, period_us, deadline_us, budget_us) \
+    { (name), (run), (period_us), (deadline_us), (budget_us), 0, 0, 0, 0, 0 }
+
+void Sched_Init(SCHED *s, SCHED_TASK *tasks, uint8_t count, SCHED_CLOCK now, uint32_t start);
+
+uint8_t Sched_Run(SCHED *s);
+
+uint32_t Sched_Idle(const SCHED *s);
+
+uint32_t Sched_Misses(const SCHED *s);
+
+#endif /* _SCHED_H_ */
+/* [] END OF FILE */
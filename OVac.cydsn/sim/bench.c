@@ -0,0 +1,470 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <project.h>
+#include "trace.h"
+#include "detect.h"
+#include "spectrum.h"
+
+/* Landing detection benchmark.
+ *
+ * Replays the descent of recorded dives through each detector of detect.h, one call per 2ms sample as
+ * Descend_Tick makes them, and scores it against the truth steps of the trace:
+ *
+ *   tp      detected at or after the bottom, within BENCH_FOUND_MS of it; latency is the time after it
+ *   fp      detected before the bottom, or on a dive that never reached one
+ *   fn      not detected within BENCH_FOUND_MS of the bottom
+ *
+ * The cost per sample is timed on this host, so it only compares detectors with each other.
+ *
+ *   ovac_bench [-n count] [-s seed] [-o report.csv] [-b baseline.csv] [trace...]
+ *
+ * Traces are read from the files given (trace.h, from 'truth descent' on) and -n generates that many more
+ * descents. -o writes one CSV row per detector. -b compares the rows with an earlier report and exits 1
+ * if a detector has more false positives or negatives, or a latency over BENCH_SLOWER of the baseline.
+ *
+ * It also times the spectral analysis of spectrum.h on the same IMU samples, per FFT window of each axis and
+ * per Goertzel block of the suction band, and checks that each finds a test tone in the right bin. A tone
+ * found in the wrong bin counts as a regression; the timings are not in the report. */
+
+#define BENCH_SAMPLE_MS         2u          // Sample_Timer period
+#define BENCH_FOUND_MS          2000u       // Later than this after the bottom is a miss
+#define BENCH_SLOWER            1.10        // Latency allowed against the baseline, plus one sample
+#define BENCH_CPU_NS            200000000.0 // Time each detector for at least this long
+#define BENCH_NAME_LEN          40u
+#define BENCH_ROW_LEN           160u
+#define BENCH_TONE              8000.0      // Test tone amplitude, counts
+
+/* Generated descent kinds */
+#define GEN_HARD                0u          // Hits the bottom hard
+#define GEN_SOFT                1u          // Settles onto the bottom, a smaller and longer rise
+#define GEN_BUMP                2u          // A knock on the way down, then a hard landing
+#define GEN_NONE                3u          // Never reaches the bottom, the descent times out
+#define GEN_KINDS               4u
+#define GEN_ONE_G               16384       // MPU6050 at +-2g
+
+typedef struct BENCH_DIVE{
+    char name[BENCH_NAME_LEN];
+    int16_t *imu;                           // az, gx, gy of each sample
+    uint32_t n;
+    int32_t bottom_ms;                      // After the first sample, -1 if it never lands
+}BENCH_DIVE;
+
+typedef struct BENCH_DIVES{
+    BENCH_DIVE *dive;
+    uint32_t count, size;
+}BENCH_DIVES;
+
+typedef struct BENCH_DETECTOR{
+    const char *name;
+    void (*reset)(void);
+    uint8_t (*sample)(int16_t az, int16_t gx, int16_t gy);
+}BENCH_DETECTOR;
+
+typedef struct BENCH_SCORE{
+    uint32_t dives, tp, fp, fn;
+    double lat_mean, lat_p95, lat_max;      // ms
+    double ns;                              // Per sample
+}BENCH_SCORE;
+
+/* functions.c comes in for ComputeMA and brings the Bluetooth transmitter with it, which is never used here */
+void UART_WriteTxData(uint8 b){
+}
+
+static DETECT_MA ma;
+static DETECT_HOLD_STATE hold;
+
+static void Ma_Reset(void){
+    memset(&ma, 0, sizeof(ma));
+    ma.id = 1;                              // As Wait_Entry leaves it
+}
+
+static uint8_t Ma_Sample(int16_t az, int16_t gx, int16_t gy){
+    return Detect_Ma(&ma, az, gx, gy);
+}
+
+static void Hold_Reset(void){
+    Detect_HoldReset(&hold);
+}
+
+static uint8_t Hold_Sample(int16_t az, int16_t gx, int16_t gy){
+    return Detect_Hold(&hold, az, gx, gy);
+}
+
+static const BENCH_DETECTOR detectors[] = {
+    { "ma",   Ma_Reset,   Ma_Sample   },    // Descend_Tick
+    { "hold", Hold_Reset, Hold_Sample },
+};
+#define DETECTORS (sizeof(detectors) / sizeof(detectors[0]))
+
+static BENCH_DIVE *New_Dive(BENCH_DIVES *dives, uint32_t n){
+    BENCH_DIVE *d;
+
+    if (dives->count == dives->size){
+        dives->size = dives->size ? dives->size * 2u : 64u;
+        dives->dive = realloc(dives->dive, dives->size * sizeof(BENCH_DIVE));
+    }
+    if (!dives->dive || !(dives->dive[dives->count].imu = malloc(3u * sizeof(int16_t) * (n ? n : 1u)))){
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    d = &dives->dive[dives->count++];
+    d->n = n;
+    d->bottom_ms = -1;
+    return d;
+}
+
+/* The 2ms samples of a trace from its truth descent step. Returns 0 if it has none. */
+static uint8_t Replay(const char *name, const SIM_STEPS *steps, BENCH_DIVES *dives){
+    int32_t descent = -1, bottom = -1, end = 0;
+    int16_t az = 0, gx = 0, gy = 0;
+    uint32_t i, k = 0, t;
+    const SIM_STEP *s;
+    BENCH_DIVE *d;
+
+    for (i = 0; i < steps->count; i++){
+        s = &steps->step[i];
+        if (s->kind == STEP_TRUTH && s->v[0] == TRUTH_DESCENT && descent < 0) descent = (int32_t)s->ms;
+        if (s->kind == STEP_TRUTH && s->v[0] == TRUTH_BOTTOM && bottom < 0) bottom = (int32_t)s->ms;
+        end = (int32_t)s->ms;
+    }
+    if (descent < 0) return 0;
+    if (bottom >= 0 && bottom + (int32_t)BENCH_FOUND_MS < end) end = bottom + (int32_t)BENCH_FOUND_MS;
+    if (end < descent) end = descent;
+
+    d = New_Dive(dives, (uint32_t)(end - descent) / BENCH_SAMPLE_MS + 1u);
+    snprintf(d->name, sizeof(d->name), "%s", name);
+    if (bottom >= descent) d->bottom_ms = bottom - descent;
+
+    for (i = 0, t = (uint32_t)descent; i < d->n; i++, t += BENCH_SAMPLE_MS){
+        for (; k < steps->count && steps->step[k].ms <= t; k++){
+            s = &steps->step[k];
+            if (s->kind == STEP_IMU){
+                az = (int16_t)s->v[0]; gx = (int16_t)s->v[1]; gy = (int16_t)s->v[2];
+            } else if (s->kind == STEP_SAMPLE){
+                az = (int16_t)s->v[1]; gx = (int16_t)s->v[2]; gy = (int16_t)s->v[3];
+            }
+        }
+        d->imu[3u * i] = az;
+        d->imu[3u * i + 1u] = gx;
+        d->imu[3u * i + 2u] = gy;
+    }
+    return 1;
+}
+
+/* A descent of one of the GEN_ kinds. Returns the kind. */
+static uint8_t Generate(uint32_t seed, BENCH_DIVES *dives){
+    uint32_t r = seed * 2654435761u + 1u;
+    uint32_t len, n, i, land = 0, impact = 0, bump = 0, bump_len = 0, t;
+    int32_t peak = 0, knock = 0;
+    uint8_t kind;
+    BENCH_DIVE *d;
+
+    Trace_Random(&r, 0);
+    kind = (uint8_t)Trace_Random(&r, GEN_KINDS);
+    len = 2000u + Trace_Random(&r, 18000u);                 // Descent, 2 to 20s
+    land = len & ~(BENCH_SAMPLE_MS - 1u);
+    if (kind == GEN_SOFT){
+        peak = 21000 + (int32_t)Trace_Random(&r, 4000u);
+        impact = 100u + Trace_Random(&r, 200u);
+    } else if (kind != GEN_NONE){
+        peak = 28000 + (int32_t)Trace_Random(&r, 4000u);
+        impact = 30u + Trace_Random(&r, 60u);
+    }
+    if (kind == GEN_BUMP){
+        bump = 500u + Trace_Random(&r, land - 1000u);
+        bump_len = 6u + Trace_Random(&r, 10u);
+        knock = 26000 + (int32_t)Trace_Random(&r, 6000u);
+    }
+    n = (kind == GEN_NONE ? len : land + BENCH_FOUND_MS) / BENCH_SAMPLE_MS;
+
+    d = New_Dive(dives, n);
+    snprintf(d->name, sizeof(d->name), "seed %lu", (unsigned long)seed);
+    if (kind != GEN_NONE) d->bottom_ms = (int32_t)land;
+    for (i = 0; i < n; i++){
+        t = i * BENCH_SAMPLE_MS;
+        d->imu[3u * i] = (int16_t)(GEN_ONE_G + (int32_t)Trace_Random(&r, 3001u) - 1500);
+        d->imu[3u * i + 1u] = (int16_t)((int32_t)Trace_Random(&r, 401u) - 200);
+        d->imu[3u * i + 2u] = (int16_t)((int32_t)Trace_Random(&r, 401u) - 200);
+        if (kind != GEN_NONE && t >= land && t < land + impact) d->imu[3u * i] = (int16_t)(peak + (int32_t)Trace_Random(&r, 1000u));
+        if (bump_len && t >= bump && t < bump + bump_len) d->imu[3u * i] = (int16_t)knock;
+    }
+    return kind;
+}
+
+static int Latency_Order(const void *a, const void *b){
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double Now_Ns(void){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void Score(const BENCH_DETECTOR *det, const BENCH_DIVES *dives, BENCH_SCORE *sc, uint8_t verbose){
+    double *lat = malloc(sizeof(double) * (dives->count ? dives->count : 1u));
+    double sum = 0, start, ns;
+    uint64_t samples = 0;
+    volatile uint8_t sink = 0;
+    const BENCH_DIVE *d;
+    int32_t found;
+    uint32_t i, j;
+
+    if (!lat){
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->dives = dives->count;
+    for (i = 0; i < dives->count; i++){
+        d = &dives->dive[i];
+        det->reset();
+        found = -1;
+        for (j = 0; j < d->n; j++){
+            if (det->sample(d->imu[3u * j], d->imu[3u * j + 1u], d->imu[3u * j + 2u]) == DETECT_BOTTOM){
+                found = (int32_t)(j * BENCH_SAMPLE_MS);
+                break;                      // Descend_Tick leaves DESCENDING
+            }
+        }
+        if (found >= 0 && (d->bottom_ms < 0 || found < d->bottom_ms)){
+            sc->fp++;
+            if (verbose) printf("%s: %s fp at %ld ms\n", det->name, d->name, (long)found);
+        } else if (found >= 0 && found - d->bottom_ms <= (int32_t)BENCH_FOUND_MS){
+            lat[sc->tp++] = found - d->bottom_ms;
+            sum += found - d->bottom_ms;
+        } else if (d->bottom_ms >= 0){
+            sc->fn++;
+            if (verbose) printf("%s: %s fn\n", det->name, d->name);
+        }
+    }
+    if (sc->tp){
+        qsort(lat, sc->tp, sizeof(double), Latency_Order);
+        sc->lat_mean = sum / sc->tp;
+        sc->lat_p95 = lat[(sc->tp * 95u + 99u) / 100u - 1u];
+        sc->lat_max = lat[sc->tp - 1u];
+    }
+    free(lat);
+
+    /* Every sample of every dive, not stopping at the detection, so each detector does the same work */
+    start = Now_Ns();
+    do {
+        for (i = 0; i < dives->count; i++){
+            d = &dives->dive[i];
+            det->reset();
+            for (j = 0; j < d->n; j++) sink ^= det->sample(d->imu[3u * j], d->imu[3u * j + 1u], d->imu[3u * j + 2u]);
+            samples += d->n;
+        }
+        ns = Now_Ns() - start;
+    } while (ns < BENCH_CPU_NS && samples);
+    sc->ns = samples ? ns / (double)samples : 0;
+}
+
+/* Time the spectrum task's FFT and the suction band's Goertzel filter over every window and block of the
+ * dives. Returns the number of test tones not found in their bin. */
+static int Spectrum(const BENCH_DIVES *dives){
+    static SPEC_WINDOW w;
+    static SPEC_GOERTZEL g;
+    uint32_t power[SPEC_FFT_N / 2u], peak, best;
+    volatile uint32_t sink = 0;
+    double start, fft_ns, goertzel_ns;
+    uint64_t windows = 0, blocks = 0;
+    const BENCH_DIVE *d;
+    uint32_t i, j;
+    uint8_t axis, k, at, wrong = 0;
+
+    start = Now_Ns();
+    do {
+        for (i = 0; i < dives->count; i++){
+            d = &dives->dive[i];
+            Spec_Clear(&w);
+            for (j = 0; j < d->n; j++){
+                Spec_Push(&w, d->imu[3u * j], d->imu[3u * j + 1u], d->imu[3u * j + 2u], 0);
+                if (w.head || !w.full) continue;
+                for (axis = 0; axis < SPEC_AXES; axis++){
+                    Spec_Fft(&w, axis, power);
+                    sink ^= power[1];
+                }
+                windows += SPEC_AXES;
+            }
+        }
+        fft_ns = Now_Ns() - start;
+    } while (fft_ns < BENCH_CPU_NS && windows);
+
+    start = Now_Ns();
+    do {
+        for (i = 0; i < dives->count; i++){
+            d = &dives->dive[i];
+            Spec_GoertzelReset(&g, 4u, 5u);
+            for (j = 0; j < d->n; j++) blocks += Spec_Goertzel(&g, d->imu[3u * j]);
+            sink ^= g.energy;
+        }
+        goertzel_ns = Now_Ns() - start;
+    } while (goertzel_ns < BENCH_CPU_NS && blocks);
+
+    /* A tone in the middle of each bin, on a 1g offset */
+    for (k = 1; k < SPEC_FFT_N / 2u; k++){
+        Spec_Clear(&w);
+        for (j = 0; j < SPEC_FFT_N; j++){
+            Spec_Push(&w, (int16_t)lround(GEN_ONE_G + BENCH_TONE * sin(2.0 * M_PI * k * j / SPEC_FFT_N)), 0, 0, 0);
+        }
+        Spec_Fft(&w, SPEC_AZ, power);
+        at = Spec_Peak(power, 1u, SPEC_FFT_N / 2u - 1u, &peak);
+        if (at != k){
+            printf("spectrum: tone in fft bin %u found in bin %u\n", k, at);
+            wrong++;
+        }
+    }
+    for (k = 1; k < SPEC_BLOCK / 2u; k++){
+        best = 0;
+        at = 0;
+        for (i = 1; i < SPEC_BLOCK / 2u; i++){
+            Spec_GoertzelReset(&g, (uint8_t)i, 1u);
+            for (j = 0; j < SPEC_BLOCK; j++){
+                Spec_Goertzel(&g, (int16_t)lround(GEN_ONE_G + BENCH_TONE * sin(2.0 * M_PI * k * j / SPEC_BLOCK)));
+            }
+            if (g.energy > best){
+                best = g.energy;
+                at = (uint8_t)i;
+            }
+        }
+        if (at != k){
+            printf("spectrum: tone in goertzel bin %u found in bin %u\n", k, at);
+            wrong++;
+        }
+    }
+
+    printf("spectrum fft_%u %.0f ns/window, goertzel_%ux5 %.0f ns/block, %u tones in the wrong bin\n", SPEC_FFT_N,
+           windows ? fft_ns / (double)windows : 0, SPEC_BLOCK, blocks ? goertzel_ns / (double)blocks : 0, wrong);
+    return wrong;
+}
+
+static void Write_Row(FILE *f, const char *name, const BENCH_SCORE *sc){
+    fprintf(f, "%s,%lu,%lu,%lu,%lu,%.1f,%.1f,%.1f,%.2f\n", name, (unsigned long)sc->dives, (unsigned long)sc->tp,
+            (unsigned long)sc->fp, (unsigned long)sc->fn, sc->lat_mean, sc->lat_p95, sc->lat_max, sc->ns);
+}
+
+/* Compare with the rows of an earlier report. Returns the number of regressions, -1 if it cannot be read. */
+static int Compare(const char *name, const BENCH_SCORE *score){
+    char row[BENCH_ROW_LEN], det[BENCH_NAME_LEN];
+    unsigned long dives, tp, fp, fn;
+    double mean, p95, max, ns;
+    int worse = 0;
+    uint32_t i;
+    FILE *f = fopen(name, "r");
+
+    if (!f){
+        perror(name);
+        return -1;
+    }
+    while (fgets(row, sizeof(row), f)){
+        if (sscanf(row, "%39[^,],%lu,%lu,%lu,%lu,%lf,%lf,%lf,%lf", det, &dives, &tp, &fp, &fn, &mean, &p95, &max,
+                   &ns) != 9) continue;     // Header
+        for (i = 0; i < DETECTORS && strcmp(det, detectors[i].name); i++);
+        if (i == DETECTORS) continue;
+        if (dives != score[i].dives){
+            printf("%s: baseline is of %lu dives, not %lu\n", det, dives, (unsigned long)score[i].dives);
+            worse++;
+            continue;
+        }
+        if (score[i].fp > fp || score[i].fn > fn){
+            printf("%s: fp %lu fn %lu, baseline fp %lu fn %lu\n", det, (unsigned long)score[i].fp,
+                   (unsigned long)score[i].fn, fp, fn);
+            worse++;
+        }
+        if (score[i].lat_mean > mean * BENCH_SLOWER + BENCH_SAMPLE_MS ||
+            score[i].lat_p95 > p95 * BENCH_SLOWER + BENCH_SAMPLE_MS){
+            printf("%s: latency mean %.1f p95 %.1f ms, baseline %.1f %.1f ms\n", det, score[i].lat_mean,
+                   score[i].lat_p95, mean, p95);
+            worse++;
+        }
+    }
+    fclose(f);
+    return worse;
+}
+
+int main(int argc, char **argv){
+    static const char header[] = "detector,dives,tp,fp,fn,lat_mean_ms,lat_p95_ms,lat_max_ms,ns_per_sample\n";
+    SIM_STEPS steps = { 0, 0, 0 };
+    BENCH_DIVES dives = { 0, 0, 0 };
+    BENCH_SCORE score[DETECTORS];
+    const char *report = 0, *baseline = 0;
+    uint32_t count = 0, seed = 1, i;
+    uint8_t verbose = 0;
+    int opt, worse = 0, wrong;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "vn:s:o:b:")) != -1){
+        if (opt == 'v') verbose = 1;
+        else if (opt == 'n') count = (uint32_t)strtoul(optarg, 0, 0);
+        else if (opt == 's') seed = (uint32_t)strtoul(optarg, 0, 0);
+        else if (opt == 'o') report = optarg;
+        else if (opt == 'b') baseline = optarg;
+        else {
+            fprintf(stderr, "usage: %s [-v] [-n count] [-s seed] [-o report.csv] [-b baseline.csv] [trace...]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    for (; optind < argc; optind++){
+        steps.count = 0;
+        if (!Trace_Load(argv[optind], &steps)) return 2;
+        if (!Replay(argv[optind], &steps, &dives)) printf("%s: no truth descent, skipped\n", argv[optind]);
+    }
+    free(steps.step);
+    for (i = 0; i < count; i++) Generate(seed + i, &dives);
+    if (!dives.count){
+        fprintf(stderr, "no dives, give traces or -n\n");
+        return 2;
+    }
+
+    printf("%-8s %6s %6s %6s %6s %10s %10s %10s %8s\n", "detector", "dives", "tp", "fp", "fn", "lat ms", "p95 ms",
+           "max ms", "ns/smp");
+    for (i = 0; i < DETECTORS; i++){
+        Score(&detectors[i], &dives, &score[i], verbose);
+        printf("%-8s %6lu %6lu %6lu %6lu %10.1f %10.1f %10.1f %8.2f\n", detectors[i].name,
+               (unsigned long)score[i].dives, (unsigned long)score[i].tp, (unsigned long)score[i].fp,
+               (unsigned long)score[i].fn, score[i].lat_mean, score[i].lat_p95, score[i].lat_max, score[i].ns);
+    }
+
+    wrong = Spectrum(&dives);
+
+    if (report){
+        f = fopen(report, "w");
+        if (!f){
+            perror(report);
+            return 2;
+        }
+        fputs(header, f);
+        for (i = 0; i < DETECTORS; i++) Write_Row(f, detectors[i].name, &score[i]);
+        fclose(f);
+    }
+    if (baseline){
+        worse = Compare(baseline, score);
+        if (worse < 0) return 2;
+        if (worse) printf("%d regressions against %s\n", worse, baseline);
+        else printf("no regressions against %s\n", baseline);
+    }
+    for (i = 0; i < dives.count; i++) free(dives.dive[i].imu);
+    free(dives.dive);
+    return (worse || wrong) ? 1 : 0;
+}
+
+/* [] END OF FILE */
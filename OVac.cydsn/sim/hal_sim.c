@@ -0,0 +1,149 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "sim.h"
+
+/* hal.h on the scenario's sensor values. Solenoid switching and log writes are collected in sim_result.
+ * The SD card is a handful of named files in memory (Sim_File), which start empty with each dive's process. */
+
+static uint8_t solenoid[2];
+static uint32_t on_since[2];
+static uint8_t imu_started = 0;
+static uint32_t adc_read = 0;               // sim_ms of the last conversion handed out
+static SIM_FILE card[SIM_FILES];
+static SIM_FILE *log_file = 0;
+static SIM_FILE *run_file = 0;              // Being downloaded
+
+void Hal_Solenoid(uint8_t which, uint8_t on){
+    which = (which == HAL_SUCTION) ? HAL_SUCTION : HAL_LIFT;
+    on = on ? 1u : 0u;
+    if (on == solenoid[which]) return;
+    solenoid[which] = on;
+    if (on){
+        on_since[which] = sim_ms;
+        sim_result.pulses[which]++;
+        if (which == HAL_LIFT && sim_plant.on && !sim_plant.active){
+            Plant_Start((sim_sensors.adc - sim_plant.surface_counts) / sim_plant.counts_per_m);
+        }
+    } else {
+        sim_result.on_ms[which] += sim_ms - on_since[which];
+    }
+    if (which == HAL_LIFT && sim_plant.active) return;     // Modulated, too many to list
+    Sim_Note("%s %s", (which == HAL_SUCTION) ? "suction" : "lift", on ? "on" : "off");
+}
+
+uint8_t Hal_SolenoidOn(uint8_t which){
+    return solenoid[(which == HAL_SUCTION) ? HAL_SUCTION : HAL_LIFT];
+}
+
+/* One conversion per simulated sample period, like the free running ADC */
+uint8_t Hal_Pressure(int32_t *counts){
+    if (sim_ms - adc_read < 2u) return 0;
+    adc_read = sim_ms;
+    *counts = sim_plant.active ? Plant_Counts() : sim_sensors.adc;
+    return 1;
+}
+
+/* The read completes by the next sample period, as it does on the bus */
+uint8_t Hal_ImuStart(void){
+    imu_started = 1;
+    return 1;
+}
+
+uint8_t Hal_ImuPoll(HAL_IMU *imu){
+    if (!imu_started) return HAL_IMU_ERROR;
+    *imu = sim_sensors.imu;
+    imu->az += Plant_Vibration();
+    return HAL_IMU_DONE;
+}
+
+/* A file on the simulated card, created if create is set and there is room. Returns 0 if there is not. */
+SIM_FILE *Sim_File(const char *name, uint8_t create){
+    SIM_FILE *free_slot = 0;
+    uint8_t i;
+
+    for (i = 0; i < SIM_FILES; i++){
+        if (card[i].name[0] && !strcmp(card[i].name, name)) return &card[i];
+        if (!card[i].name[0] && !free_slot) free_slot = &card[i];
+    }
+    if (!create || !free_slot) return 0;
+    snprintf(free_slot->name, sizeof(free_slot->name), "%s", name);
+    free_slot->len = 0;
+    return free_slot;
+}
+
+uint8_t Hal_LogOpen(const char *name, uint8_t append){
+    Hal_LogClose();
+    log_file = Sim_File(name, 1);
+    if (!log_file) return 0;
+    if (!append) log_file->len = 0;
+    return 1;
+}
+
+uint16_t Hal_LogWrite(const void *data, uint16_t len){
+    if (!log_file) return 0;
+    if (log_file->len + len > log_file->size){
+        log_file->size = (log_file->len + len) * 2u;
+        log_file->data = realloc(log_file->data, log_file->size);
+        if (!log_file->data){
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+    }
+    memcpy(&log_file->data[log_file->len], data, len);
+    log_file->len += len;
+    sim_result.log_bytes += len;
+    return len;
+}
+
+uint8_t Hal_LogRewrite(uint32_t offset, const void *data, uint16_t len){
+    if (!log_file || offset > log_file->len || len > log_file->len - offset) return 0;
+    memcpy(&log_file->data[offset], data, len);
+    return 1;
+}
+
+void Hal_LogClose(void){
+    log_file = 0;
+}
+
+int32_t Hal_RunOpen(uint16_t run){
+    char name[RUN_FILE_NAME_LEN];
+
+    Transfer_RunName(name, run);
+    run_file = Sim_File(name, 0);
+    return run_file ? (int32_t)run_file->len : -1;
+}
+
+uint16_t Hal_RunRead(uint32_t offset, uint8_t *buf, uint16_t len){
+    if (!run_file || offset >= run_file->len) return 0;
+    if (len > run_file->len - offset) len = (uint16_t)(run_file->len - offset);
+    memcpy(buf, &run_file->data[offset], len);
+    return len;
+}
+
+void Hal_RunClose(void){
+    run_file = 0;
+}
+
+/* Close the books at the end of a run, for a solenoid still on */
+void Sim_HalEnd(void){
+    uint8_t i;
+
+    for (i = 0; i < 2u; i++){
+        if (solenoid[i]) sim_result.on_ms[i] += sim_ms - on_since[i];
+    }
+}
+
+/* [] END OF FILE */
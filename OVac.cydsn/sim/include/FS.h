@@ -0,0 +1,21 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef _SIM_FS_H_
+#define _SIM_FS_H_
+
+/* Stand-in for the emFile FS.h in the host simulator build. functions.h includes it, but nothing the
+ * simulator links uses emFile: the log and run files go through hal.h. */
+
+typedef struct FS_FILE FS_FILE;
+
+#endif /* _SIM_FS_H_ */
+/* [] END OF FILE */
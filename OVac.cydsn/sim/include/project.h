@@ -0,0 +1,56 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef _SIM_PROJECT_H_
+#define _SIM_PROJECT_H_
+
+/* Stand-in for the PSoC Creator project.h in the host simulator build.
+ *
+ * Only what the shared modules (events, timer, transfer, bluetooth, power, display) use from the generated
+ * API is here. The simulator is single threaded and runs the "ISRs" itself between main loop passes, so
+ * critical sections are empty and halting the CPU means running the next millisecond of simulated time. */
+
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+
+#define CY_ISR(name)            void name(void)
+#define CY_ISR_PROTO(name)      void name(void)
+
+#define CyEnterCriticalSection()    ((uint8)0u)
+#define CyExitCriticalSection(s)    ((void)(s))
+
+/* Flight recorder: a host process has no RAM that survives a reset, every run is a power on */
+#define CY_NOINIT
+#define CyResetStatus               ((uint8)0u)
+
+/* Power_Idle */
+#define PM_ALT_ACT_TIME_NONE    0u
+#define PM_ALT_ACT_SRC_NONE     0u
+#define CyPmAltAct(time, src)   Sim_Idle()
+#define CY_PM_WFI               Sim_Idle()
+
+void Sim_Idle(void);
+
+/* Bluetooth UART transmit side, used by BT_TxService. The simulated FIFO never fills. */
+#define UART_TX_STS_FIFO_NOT_FULL   0x02u
+#define UART_ReadTxStatus()         UART_TX_STS_FIFO_NOT_FULL
+
+void UART_WriteTxData(uint8 b);
+
+#endif /* _SIM_PROJECT_H_ */
+/* [] END OF FILE */
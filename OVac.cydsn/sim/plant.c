@@ -0,0 +1,130 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <math.h>
+#include <string.h>
+#include "sim.h"
+#include "ascent.h"
+
+/* Buoyancy model of the ascent, for tuning and checking the lift bag controller (ascent.h).
+ *
+ * The device is a negatively buoyant body with an open bottomed lift bag. While the lift valve is open gas
+ * flows into the bag at PLANT_FLOW litres per second measured at surface pressure; the bag volume follows
+ * Boyle's law with depth and spills whatever exceeds PLANT_BAG_L. Buoyancy less the wet weight less
+ * quadratic drag accelerates the device and its added mass. The bottom holds it up until it has lift.
+ *
+ * In generated dives the model takes over the pressure reading from the trace when the lift valve first
+ * opens, starting from the depth the trace had reached, so the controller sees the result of its own
+ * inflation. Scenario files keep their own pressure trace.
+ *
+ * The suction flow shakes the housing with a tone of flow_amp counts of z acceleration at flow_hz while
+ * the suction valve is open, dying away over PLANT_SEAL_TAU once the valve has been open seal_ms and the
+ * cup has sealed. It is added to the IMU readings of generated dives. */
+
+#define PLANT_P0                101325.0    // Pa at the surface
+#define PLANT_RHO_G             10050.0     // Pa per m of sea water
+#define PLANT_WEIGHT_N          9.8         // Wet weight, 1kg negative
+#define PLANT_MASS_KG           8.0         // With added mass
+#define PLANT_DRAG              15.0        // N per (m/s)^2, 0.5 rho Cd A
+#define PLANT_FLOW              1.0         // Surface litres per second with the valve open
+#define PLANT_BAG_L             3.0
+#define PLANT_DT                0.001       // One simulated millisecond
+#define PLANT_NOISE             5u          // Counts, +-2 like the generated traces
+#define PLANT_SEAL_TAU          30.0        // ms
+
+SIM_PLANT sim_plant;
+
+/* Take over from the trace at depth_m, still */
+void Plant_Start(double depth_m){
+    sim_plant.active = 1;
+    sim_plant.depth = (depth_m > 0.0) ? depth_m : 0.0;
+    sim_plant.v = 0.0;
+    sim_plant.gas = 0.0;
+    sim_plant.start_ms = sim_ms;
+    sim_plant.surfaced_ms = 0;
+    sim_result.ascent_from_cm = (int32_t)lround(sim_plant.depth * 100.0);
+}
+
+static void Step(SIM_PLANT *p, uint8_t valve_open){
+    double pressure = PLANT_P0 + PLANT_RHO_G * p->depth;
+    double volume, force;
+
+    if (valve_open) p->gas += PLANT_FLOW * PLANT_DT;
+    volume = p->gas * PLANT_P0 / pressure;
+    if (volume > PLANT_BAG_L){
+        volume = PLANT_BAG_L;
+        p->gas = PLANT_BAG_L * pressure / PLANT_P0;     // Spilled out of the bottom
+    }
+    force = PLANT_RHO_G * volume / 1000.0 - PLANT_WEIGHT_N - PLANT_DRAG * p->v * fabs(p->v);
+    p->v += force / PLANT_MASS_KG * PLANT_DT;
+    if (p->depth >= p->bottom && p->v < 0.0) p->v = 0.0;   // On the bottom
+    p->depth -= p->v * PLANT_DT;
+    if (p->depth > p->bottom) p->depth = p->bottom;
+    if (p->depth <= 0.0){
+        p->depth = 0.0;
+        if (p->v > 0.0) p->v = 0.0;
+    }
+}
+
+/* One millisecond of the ascent */
+void Plant_Step(uint8_t valve_open){
+    if (!sim_plant.active) return;
+    Step(&sim_plant, valve_open);
+    if (sim_plant.depth <= ASC_SURFACE_CM / 100.0 && !sim_plant.surfaced_ms) sim_plant.surfaced_ms = sim_ms;
+}
+
+/* One millisecond of the suction valve */
+void Plant_Suction(uint8_t valve_open){
+    sim_plant.suction_open = valve_open;
+    if (valve_open) sim_plant.suction_ms++;
+}
+
+/* Z acceleration counts the suction flow adds */
+int16_t Plant_Vibration(void){
+    double amp = sim_plant.flow_amp;
+
+    if (!sim_plant.on || !sim_plant.suction_open || amp == 0.0) return 0;
+    if (sim_plant.seal_ms && sim_plant.suction_ms > sim_plant.seal_ms){
+        amp *= exp(-(double)(sim_plant.suction_ms - sim_plant.seal_ms) / PLANT_SEAL_TAU);
+    }
+    return (int16_t)lround(amp * sin(2.0 * M_PI * sim_plant.flow_hz * sim_ms / 1000.0));
+}
+
+/* Pressure ADC counts at the modelled depth */
+int32_t Plant_Counts(void){
+    sim_plant.noise = sim_plant.noise * 1103515245u + 12345u;
+    return (int32_t)lround(sim_plant.surface_counts + sim_plant.depth * sim_plant.counts_per_m) +
+           (int32_t)((sim_plant.noise >> 16) % PLANT_NOISE) - (int32_t)(PLANT_NOISE / 2u);
+}
+
+/* The lift pattern dive.c used before the closed loop, for comparison: pulses of on_ms on and off_ms off
+ * from depth_m. Returns the milliseconds to the surface, 0 if it is not reached by ASC_TIMEOUT_MS, and the
+ * valve open time in *open_ms. */
+uint32_t Plant_Fixed(double depth_m, double bottom_m, uint8_t pulses, uint32_t on_ms, uint32_t off_ms,
+                     uint32_t *open_ms){
+    SIM_PLANT p;
+    uint32_t t;
+    uint8_t open;
+
+    memset(&p, 0, sizeof(p));
+    p.depth = depth_m;
+    p.bottom = bottom_m;
+    *open_ms = 0;
+    for (t = 0; t < ASC_TIMEOUT_MS; t++){
+        open = t < pulses * (on_ms + off_ms) && t % (on_ms + off_ms) < on_ms;
+        *open_ms += open;
+        Step(&p, open);
+        if (p.depth <= ASC_SURFACE_CM / 100.0) return t + 1u;
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
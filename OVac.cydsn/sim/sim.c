@@ -0,0 +1,658 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "trace.h"
+#include "dive.h"
+#include "functions.h"
+#include "protocol.h"
+#include "bluetooth.h"
+#include "events.h"
+#include "timer.h"
+#include "clock.h"
+#include "power.h"
+#include "display.h"
+#include "jitter.h"
+#include "solenoid.h"
+#include "suction.h"
+#include "transfer.h"
+
+/* Host simulator of the dive controller.
+ *
+ * Links dive.c and the modules under it (fsm, events, timer, sched, protocol, bluetooth, telemetry,
+ * transfer, display, power, functions) unchanged against simulated peripherals: hal_sim.c for the sensors,
+ * solenoids and an SD card in memory, sim_lcd.c for the LCD, sim_clock.c for the clock, and this file for
+ * the Bluetooth link. Time only moves when the controller idles: Power_Idle halts through CyPmAltAct, which
+ * here is Sim_Idle, and Sim_Idle runs the next millisecond (the countdown ISR, the scenario steps due, and
+ * every 2ms the Sample_Timer ISR). A dive runs as fast as the controller's own work allows.
+ *
+ *   ovac_sim [-v] scenario...          Run scenario files
+ *   ovac_sim [-v] -n count [-s seed]   Run generated dives and check each took the path expected of it
+ *
+ * Scenario files are traces in the format of trace.h. A scenario that misses its expect lines fails the run.
+ *
+ * Each dive runs in its own process, so every module starts from its power on state.
+ *
+ * Generated dives model the ascent (plant.c): once the lift valve opens, the pressure comes from a buoyancy
+ * model driven by the valve rather than from the trace. Each dive is checked to reach the surface in the
+ * model, and the summary compares the closed loop ascent with the fixed lift pattern it replaced. They also
+ * model the vibration of the suction flow: the cup seals after a random time, never seals, or the flow does
+ * not show on the IMU, and each dive is checked to have held the suction for as long as that calls for. */
+
+#define SIM_TAIL_MS             60000u      // Run on after the last step when there is no end step
+#define SIM_MAX_MS              (24u * 3600u * 1000u)
+
+/* dive.c timing the generated dives are checked against */
+#define GEN_LAUNCH_MS           10000u      // LAUNCH_SECONDS
+#define GEN_SETTLE_MS           15000u      // SETTLE_SECONDS
+#define GEN_BOTTOM_MS           23000u      // SETTLE_SECONDS + SUCTION_SECONDS + RELEASE_SECONDS
+#define GEN_SUCTION_MS          5000u       // SUCTION_SECONDS, the default suction profile
+#define GEN_ASCENT_MS           120000u     // Longest ascent a generated dive allows
+#define GEN_FIXED_PULSES        2u          // The fixed lift pattern before the closed loop: LIFT_PULSES
+#define GEN_FIXED_ON_MS         3000u       // of LIFT_SECONDS on
+#define GEN_FIXED_OFF_MS        1000u       // and LIFT_OFF_SECONDS off
+#define GEN_SEAL_LATE_MS        1200u       // Suction may run on this long after the cup seals
+#define GEN_GRID_MS             10u         // Trace resolution
+#define GEN_ONE_G               16384       // MPU6050 at +-2g
+#define GEN_COUNTS_PER_CM       (HAL_ADC_COUNTS / HAL_ADC_VOLTS / PRESSURE_CM_PER_VOLT)
+
+/* Suction flows */
+#define GEN_FLOW_SEALS          0u          // Seals after seal_ms
+#define GEN_FLOW_OPEN           1u          // Never seals, runs to SUC_MAX_MS
+#define GEN_FLOW_SILENT         2u          // Does not show on the IMU, the profile runs as set
+
+/* Generated dive kinds */
+#define GEN_LANDED              0u          // Hits the bottom hard enough to register
+#define GEN_SOFT                1u          // Settles without an impact, the descent times out
+#define GEN_LEAK                2u          // Water in the housing at some point of the dive
+#define GEN_KINDS               3u
+
+static const char state_letter[] = "CWDLRTE";   // Indexed by STATES
+static const char *const state_name[] = {
+    "SYSTEM_CHECK", "WAIT_TO_LAUNCH", "DESCENDING", "LANDED", "RESURFACE", "TRANSMIT", "ERROR"
+};
+
+uint32_t sim_ms = 0;
+SIM_SENSORS sim_sensors;
+SIM_RESULT sim_result;
+uint8_t sim_verbose = 0;
+
+static const SIM_STEPS *script;
+static uint32_t script_next;
+static uint32_t end_ms;
+static uint8_t running;
+
+static uint8_t rx_frame[PROTO_HEADER_LEN + PROTO_TX_MAX_PAYLOAD + PROTO_CRC_LEN + 8u];
+static uint16_t rx_len = 0;
+
+/* Run download by the host, the run and offset of the last CMD_DATA */
+static uint16_t dl_run;
+static uint32_t dl_next;                    // Every byte before this has arrived and matches the card
+static uint8_t dl_ack;                      // An ack of dl_next is due
+
+void Sim_Note(const char *fmt, ...){
+    va_list ap;
+
+    if (!sim_verbose) return;
+    printf("%6lu.%03lu  ", (unsigned long)(sim_ms / 1000u), (unsigned long)(sim_ms % 1000u));
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+}
+
+/* Host side of the Bluetooth link: frame a command and feed it to the parser, as rx_interrupt does */
+static void Host_Send(uint8_t cmd, const uint8_t *payload, uint8_t len){
+    uint8_t raw[PROTO_HEADER_LEN + PROTO_RX_MAX_PAYLOAD + PROTO_CRC_LEN];
+    uint8_t out[sizeof(raw) + 2u];
+    uint16_t crc = 0xFFFFu, n, i, o = 1, code_at = 0;
+    uint8_t code = 1;
+
+    raw[0] = cmd;
+    raw[1] = len;
+    memcpy(&raw[PROTO_HEADER_LEN], payload, len);
+    n = PROTO_HEADER_LEN + len;
+    for (i = 0; i < n; i++) crc = Proto_Crc16(crc, raw[i]);
+    raw[n++] = (uint8_t)(crc >> 8);
+    raw[n++] = (uint8_t)crc;
+
+    for (i = 0; i < n; i++){                // COBS, frames are far shorter than one 254 byte block
+        if (raw[i] == 0){
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        } else {
+            out[o++] = raw[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+
+    for (i = 0; i < o; i++) Proto_RxByte(out[i]);
+    Proto_RxByte(0);
+}
+
+/* The run being downloaded, as it is on the card */
+static const SIM_FILE *Host_Run(void){
+    char name[RUN_FILE_NAME_LEN];
+
+    Transfer_RunName(name, dl_run);
+    return Sim_File(name, 0);
+}
+
+/* A chunk of the run download: keep it if it carries on from dl_next, and check it against the card */
+static void Host_Chunk(const uint8_t *p, uint8_t len){
+    const SIM_FILE *run = Host_Run();
+    uint32_t offset = Proto_GetU32(p);
+    uint16_t n, i, crc = 0xFFFFu;
+
+    if (len < PROTO_CHUNK_HDR_LEN + 2u){
+        sim_result.download_bad = 1;
+        return;
+    }
+    n = len - PROTO_CHUNK_HDR_LEN - 2u;
+    for (i = 0; i < n; i++) crc = Proto_Crc16(crc, p[PROTO_CHUNK_HDR_LEN + i]);
+    if (crc != Proto_GetU16(&p[PROTO_CHUNK_HDR_LEN + n])){
+        sim_result.download_bad = 1;        // The link here never corrupts
+        return;
+    }
+    if (offset != dl_next) return;          // Resent or out of order, the ack says where the host is
+    if (!run || offset + n > run->len || memcmp(&run->data[offset], &p[PROTO_CHUNK_HDR_LEN], n)){
+        sim_result.download_bad = 1;
+    }
+    dl_next += n;
+    dl_ack = 1;
+}
+
+static void Host_DataEnd(uint32_t size){
+    const SIM_FILE *run = Host_Run();
+
+    if (!run || size != run->len || dl_next != size) sim_result.download_bad = 1;
+    sim_result.download_bytes = dl_next;
+    Sim_Note("bt run %u downloaded, %lu bytes", dl_run, (unsigned long)dl_next);
+}
+
+/* A complete frame from the device */
+static void Host_Frame(const uint8_t *f, uint16_t n){
+    char text[PROTO_TX_MAX_PAYLOAD + 1u];
+    uint16_t crc = 0xFFFFu, i;
+
+    if (n < PROTO_HEADER_LEN + PROTO_CRC_LEN || f[1] != n - PROTO_HEADER_LEN - PROTO_CRC_LEN){
+        sim_result.bad_frames++;
+        return;
+    }
+    for (i = 0; i < n - PROTO_CRC_LEN; i++) crc = Proto_Crc16(crc, f[i]);
+    if (crc != (uint16_t)((f[n - 2u] << 8) | f[n - 1u])){
+        sim_result.bad_frames++;
+        return;
+    }
+    sim_result.frames++;
+
+    switch (f[0]){
+        case RSP_TEXT:
+            for (i = 0; i < f[1]; i++) text[i] = (f[2 + i] == '\n') ? ' ' : (char)f[2 + i];
+            text[i] = 0;
+            Sim_Note("bt \"%s\"", text);
+            break;
+        case RSP_ACK:
+            Sim_Note("bt ack %02x", f[2]);
+            break;
+        case RSP_NAK:
+            sim_result.naks++;
+            Sim_Note("bt nak %02x reason %u", f[2], f[3]);
+            break;
+        case RSP_TELEMETRY:
+            break;                          // Too many to list
+        case RSP_CHUNK:
+            Host_Chunk(&f[PROTO_HEADER_LEN], f[1]);
+            break;
+        case RSP_DATA_END:
+            Host_DataEnd(Proto_GetU32(&f[PROTO_HEADER_LEN]));
+            break;
+        default:
+            Sim_Note("bt frame %02x, %u bytes", f[0], f[1]);
+            break;
+    }
+}
+
+/* The Bluetooth module: bytes the device sends, split into frames and COBS decoded */
+void UART_WriteTxData(uint8 b){
+    uint16_t i = 0, o = 0;
+    uint8_t code, k;
+
+    if (b != 0){
+        if (rx_len < sizeof(rx_frame)) rx_frame[rx_len++] = b;
+        return;
+    }
+    while (i < rx_len){
+        code = rx_frame[i++];
+        for (k = 1; k < code; k++){
+            if (i >= rx_len){
+                sim_result.bad_frames++;
+                rx_len = 0;
+                return;
+            }
+            rx_frame[o++] = rx_frame[i++];  // Decoding never gets ahead of the input
+        }
+        if (code != 0xFFu && i < rx_len) rx_frame[o++] = 0;
+    }
+    rx_len = 0;
+    if (o) Host_Frame(rx_frame, o);
+}
+
+static void Step(const SIM_STEP *s){
+    switch (s->kind){
+        case STEP_CMD:
+            if (s->cmd == CMD_DATA){
+                dl_run = Proto_GetU16(s->payload);
+                dl_next = Proto_GetU32(&s->payload[2]);
+            }
+            Host_Send(s->cmd, s->payload, s->len);
+            break;
+        case STEP_SAMPLE:
+            sim_sensors.adc = s->v[0];
+            sim_sensors.imu.az = (int16_t)s->v[1];
+            sim_sensors.imu.gx = (int16_t)s->v[2];
+            sim_sensors.imu.gy = (int16_t)s->v[3];
+            sim_sensors.imu.gz = (int16_t)s->v[4];
+            break;
+        case STEP_IMU:
+            sim_sensors.imu.az = (int16_t)s->v[0];
+            sim_sensors.imu.gx = (int16_t)s->v[1];
+            sim_sensors.imu.gy = (int16_t)s->v[2];
+            sim_sensors.imu.gz = (int16_t)s->v[3];
+            break;
+        case STEP_ADC:
+            sim_sensors.adc = s->v[0];
+            break;
+        case STEP_WATER:
+            Sim_Note("water");
+            Event_Post(EV_WATER, 0);        // Moisture_ISR_Handler
+            break;
+        case STEP_END:
+            running = 0;
+            break;
+        case STEP_TRUTH:
+            break;                          // For bench.c
+    }
+}
+
+/* One millisecond of simulated time, in place of the halt in Power_Idle */
+void Sim_Idle(void){
+    sim_ms++;
+    Clock_Tick();                           // Countdown ISR
+    Timer_Tick(clock_ms);
+    Sol_Tick();
+    BT_TxService();                         // No bt_tx_isr here, the countdown tick refills the FIFO
+    Plant_Step(Hal_SolenoidOn(HAL_LIFT));
+    Plant_Suction(Hal_SolenoidOn(HAL_SUCTION));
+    while (script_next < script->count && script->step[script_next].ms <= sim_ms){
+        Step(&script->step[script_next++]);
+    }
+    if (dl_ack){                            // The host acks what it has, a millisecond after the chunk
+        uint8_t ack[PROTO_DATA_ACK_LEN];
+
+        dl_ack = 0;
+        Proto_PutU32(ack, dl_next);
+        Host_Send(CMD_DATA_ACK, ack, sizeof(ack));
+    }
+    if ((sim_ms & 1u) == 0) Dive_SampleTick();  // Sample_Timer ISR
+    if (sim_ms >= end_ms) running = 0;
+}
+
+/* Run one dive from power on in this process, leaving what it did in sim_result */
+static void Run(const SIM_STEPS *steps){
+    uint8_t state, last;
+    uint8_t n = 0;
+
+    script = steps;
+    script_next = 0;
+    end_ms = steps->count ? steps->step[steps->count - 1u].ms + SIM_TAIL_MS : SIM_TAIL_MS;
+    if (steps->count && steps->step[steps->count - 1u].kind == STEP_END) end_ms = steps->step[steps->count - 1u].ms;
+    if (end_ms > SIM_MAX_MS) end_ms = SIM_MAX_MS;
+    memset(&sim_result, 0, sizeof(sim_result));
+    sim_ms = 0;
+    running = 1;
+
+    Clock_Start();
+    Dive_Init();
+    Dive_LogOpen();                         // The card as main.c Boot_Sd leaves it, empty: run 1
+    BT_TxStart();
+    Dive_Start();
+    Power_Start();
+
+    last = Dive_State();
+    sim_result.path[n++] = state_letter[last];
+    while (running){
+        Dive_Loop();
+        state = Dive_State();
+        if (state != last){
+            if (n < SIM_PATH_LEN) sim_result.path[n++] = state_letter[state];
+            Sim_Note("state %s", state_name[state]);
+            last = state;
+        }
+        if (Sim_LcdChanged() && sim_verbose && !Display_Pending()){
+            Sim_Note("lcd [%s] [%s]", sim_lcd[0], sim_lcd[1]);
+        }
+    }
+    Sim_HalEnd();
+    if (sim_plant.surfaced_ms) sim_result.ascent_ms = sim_plant.surfaced_ms - sim_plant.start_ms;
+    sim_result.ticks_missed = jitter_stats.missed;
+    sim_result.interval_max_us = jitter_stats.max_us;
+    sim_result.path[n] = 0;
+    sim_result.state = last;
+    sim_result.end_ms = sim_ms;
+}
+
+/* Run one dive in a child process. Returns 0 if it crashed. */
+static uint8_t Run_Child(const SIM_STEPS *steps, SIM_RESULT *r){
+    int fd[2], status;
+    pid_t pid;
+    ssize_t n;
+
+    fflush(stdout);
+    if (pipe(fd)) return 0;
+    pid = fork();
+    if (pid == 0){
+        close(fd[0]);
+        Run(steps);
+        fflush(stdout);
+        n = write(fd[1], &sim_result, sizeof(sim_result));
+        _exit(n == (ssize_t)sizeof(sim_result) ? 0 : 1);
+    }
+    close(fd[1]);
+    n = (pid < 0) ? 0 : read(fd[0], r, sizeof(*r));
+    close(fd[0]);
+    if (pid > 0) waitpid(pid, &status, 0);
+    return pid > 0 && n == (ssize_t)sizeof(*r) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Keep a generated leak clear of the moment t, where which side of it the leak falls decides the path */
+static uint32_t Clear_Of(uint32_t leak, uint32_t t){
+    return (leak + 200u > t && leak < t + 200u) ? t + 200u : leak;
+}
+
+/* A dive with the sensor trace of one of the GEN_ kinds. Returns the kind, the path it should take and the
+ * number of times it should run the suction. */
+static uint8_t Generate(uint32_t seed, SIM_STEPS *steps, const char **expect, uint8_t *suction){
+    uint32_t r = seed * 2654435761u + 1u;
+    uint32_t depth_ft, t_depth, launch, land, allowed, rise, leak = 0, end, t;
+    int32_t surface, bottom, counts;
+    uint8_t kind, flow;
+    SIM_STEP *s;
+
+    Trace_Random(&r, 0);
+    kind = (uint8_t)Trace_Random(&r, GEN_KINDS);
+    depth_ft = 10u + Trace_Random(&r, 190u);
+    surface = 600 + (int32_t)Trace_Random(&r, 100u);
+    bottom = surface + (int32_t)(depth_ft * 30.48f * GEN_COUNTS_PER_CM);
+    t_depth = 200u + Trace_Random(&r, 800u);
+    launch = t_depth + GEN_LAUNCH_MS;
+    land = launch + 500u + depth_ft * 2000u / 13u + Trace_Random(&r, 1000u); // 2 to 3s per 13 feet
+    allowed = ((depth_ft / 13u) + 3u) * 2000u;                              // dive.c Launch
+
+    *expect = "WDLRT";
+    *suction = 1;
+    rise = land + GEN_BOTTOM_MS;
+    if (kind == GEN_SOFT){
+        *expect = "WDRT";
+        *suction = 0;
+        rise = launch + allowed;
+    } else if (kind == GEN_LEAK){
+        leak = launch + 500u + Trace_Random(&r, land + GEN_BOTTOM_MS - launch - 1000u);
+        leak = Clear_Of(Clear_Of(leak, land), land + GEN_SETTLE_MS);
+        if (leak < land) *expect = "WDRT";
+        if (leak < land + GEN_SETTLE_MS) *suction = 0;          // Surfaces before the suction starts
+        rise = leak;
+    }
+    end = rise + GEN_ASCENT_MS + 2000u;
+    sim_plant.on = 1;
+    sim_plant.surface_counts = surface;
+    sim_plant.counts_per_m = GEN_COUNTS_PER_CM * 100.0;
+    sim_plant.bottom = (bottom - surface) / sim_plant.counts_per_m;
+
+    Trace_Command(steps, 100u, CMD_START, 0, 0);
+    Trace_Command(steps, t_depth, CMD_DEPTH, depth_ft, 0);
+    if (leak) Trace_Push(steps, leak, STEP_WATER);
+
+    for (t = 0; t < end; t += GEN_GRID_MS){
+        if (t < launch) counts = surface;
+        else if (t < land) counts = surface + (bottom - surface) * (int32_t)(t - launch) / (int32_t)(land - launch);
+        else counts = bottom;               // The ascent is modelled from the first lift valve opening
+
+        s = Trace_Push(steps, t, STEP_SAMPLE);
+        s->v[0] = counts + (int32_t)Trace_Random(&r, 5u) - 2;
+        s->v[1] = GEN_ONE_G + (int32_t)Trace_Random(&r, 3001u) - 1500;
+        s->v[2] = (int32_t)Trace_Random(&r, 401u) - 200;
+        s->v[3] = (int32_t)Trace_Random(&r, 401u) - 200;
+        s->v[4] = (int32_t)Trace_Random(&r, 401u) - 200;
+        if (kind != GEN_SOFT && t >= land && t < land + 60u) s->v[1] = 28000 + (int32_t)Trace_Random(&r, 4000u);
+    }
+    Trace_Push(steps, end, STEP_END);
+    Trace_Sort(steps);
+
+    flow = (uint8_t)Trace_Random(&r, 8u);
+    sim_plant.suction_ms = 0;
+    sim_plant.flow_hz = 60.0 + Trace_Random(&r, 66u);
+    sim_plant.flow_amp = (flow == 7u) ? 0.0 : 800.0 + Trace_Random(&r, 1200u);
+    sim_plant.seal_ms = (flow == 6u) ? 0u : 1000u + Trace_Random(&r, 8000u);
+    return kind;
+}
+
+/* The suction flow Generate set up */
+static uint8_t Gen_Flow(void){
+    if (sim_plant.flow_amp == 0.0) return GEN_FLOW_SILENT;
+    return sim_plant.seal_ms ? GEN_FLOW_SEALS : GEN_FLOW_OPEN;
+}
+
+/* Returns 1 if a generated dive did what its kind should */
+static uint8_t Check(const SIM_RESULT *r, const char *expect, uint8_t suction, uint8_t kind){
+    uint32_t on = r->on_ms[HAL_SUCTION], low, high;
+
+    if (strcmp(r->path, expect) || r->state != TRANSMIT) return 0;
+    if (r->bad_frames || r->naks || r->ticks_missed) return 0;
+    if (!r->log_bytes) return 0;            // Nothing reached the SD log
+    if (!r->ascent_ms) return 0;            // Never reached the surface
+    if (r->pulses[HAL_SUCTION] != suction) return 0;
+    if (!suction || kind == GEN_LEAK) return 1;         // A leak can cut the suction short
+    switch (Gen_Flow()){
+        case GEN_FLOW_SEALS:
+            if (on == GEN_SUCTION_MS) return 1;         // Too faint to show, the profile ran as set
+            low = (sim_plant.seal_ms > SUC_MIN_MS) ? sim_plant.seal_ms : SUC_MIN_MS;
+            high = low + GEN_SEAL_LATE_MS;
+            break;
+        case GEN_FLOW_OPEN:
+            low = high = SUC_MAX_MS;
+            break;
+        default:
+            low = high = GEN_SUCTION_MS;
+            break;
+    }
+    return on + 2u >= low && on <= high + 2u;
+}
+
+static void Print_Result(const char *name, const SIM_RESULT *r){
+    printf("%s: path %s, %s at %lu.%03lus, suction %u x %lums, lift %u x %lums, frames %lu (%lu bad), naks %lu, "
+           "log %lu bytes, ticks missed %lu (max interval %luus), ascent %lums\n", name, r->path, state_name[r->state < ERROR ? r->state : ERROR],
+           (unsigned long)(r->end_ms / 1000u), (unsigned long)(r->end_ms % 1000u),
+           r->pulses[HAL_SUCTION], (unsigned long)r->on_ms[HAL_SUCTION],
+           r->pulses[HAL_LIFT], (unsigned long)r->on_ms[HAL_LIFT], (unsigned long)r->frames,
+           (unsigned long)r->bad_frames, (unsigned long)r->naks, (unsigned long)r->log_bytes,
+           (unsigned long)r->ticks_missed, (unsigned long)r->interval_max_us, (unsigned long)r->ascent_ms);
+    if (r->download_bytes || r->download_bad){
+        printf("  download %lu bytes%s\n", (unsigned long)r->download_bytes, r->download_bad ? ", not as on the card" : "");
+    }
+}
+
+/* Returns 1 if a scenario met its expect lines (trace.h) */
+static uint8_t Check_Expect(const char *name, const SIM_STEPS *steps, const SIM_RESULT *r){
+    const char *state = state_name[r->state < ERROR ? r->state : ERROR];
+    uint8_t ok = 1;
+
+    if (steps->expect_path[0] && strcmp(r->path, steps->expect_path)){
+        printf("%s: expected path %s\n", name, steps->expect_path);
+        ok = 0;
+    }
+    if (steps->expect_state[0] && strcmp(state, steps->expect_state)){
+        printf("%s: expected to end in %s\n", name, steps->expect_state);
+        ok = 0;
+    }
+    if (steps->expect_download && (!r->download_bytes || r->download_bad)){
+        printf("%s: expected a run download matching the card\n", name);
+        ok = 0;
+    }
+    return ok;
+}
+
+static int Run_Generated(uint32_t count, uint32_t seed){
+    static const char *const kind_name[GEN_KINDS] = { "landed", "soft", "leak" };
+    static const char *const flow_name[3] = { "seals", "open", "silent" };
+    SIM_STEPS steps = { 0, 0, 0 };
+    SIM_RESULT r;
+    const char *expect;
+    uint32_t i, runs[GEN_KINDS] = { 0 }, ok[GEN_KINDS] = { 0 }, failed = 0;
+    uint64_t simulated = 0;
+    uint32_t suctions[3] = { 0 }, sealed = 0, fixed_sealed = 0;    // By GEN_FLOW_
+    uint64_t suction_sum[3] = { 0 }, seal_sum = 0;
+    uint32_t ascents = 0, surfaced = 0, ascent_max = 0, fixed_up = 0, fixed_open, fixed_ms;
+    uint64_t ascent_sum = 0, lift_sum = 0, fixed_sum = 0, fixed_open_sum = 0;
+    uint64_t both_sum = 0, both_lift_sum = 0;          // Closed loop on the dives the fixed pattern surfaced
+    struct timespec start, stop;
+    double secs;
+    uint8_t kind, suction;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++){
+        steps.count = 0;
+        kind = Generate(seed + i, &steps, &expect, &suction);
+        runs[kind]++;
+        if (sim_verbose) printf("dive %lu: %s, expect %s\n", (unsigned long)(seed + i), kind_name[kind], expect);
+        if (!Run_Child(&steps, &r)){
+            printf("seed %lu: crashed\n", (unsigned long)(seed + i));
+            failed++;
+            continue;
+        }
+        simulated += r.end_ms;
+        ascents++;                          // Every dive ends in an ascent, failed or not
+        if (r.ascent_ms){
+            surfaced++;
+            ascent_sum += r.ascent_ms;
+            lift_sum += r.on_ms[HAL_LIFT];
+            if (r.ascent_ms > ascent_max) ascent_max = r.ascent_ms;
+            fixed_ms = Plant_Fixed(r.ascent_from_cm / 100.0, sim_plant.bottom, GEN_FIXED_PULSES, GEN_FIXED_ON_MS,
+                                   GEN_FIXED_OFF_MS, &fixed_open);
+            if (fixed_ms){
+                fixed_up++;
+                fixed_sum += fixed_ms;
+                fixed_open_sum += fixed_open;
+                both_sum += r.ascent_ms;
+                both_lift_sum += r.on_ms[HAL_LIFT];
+            }
+        }
+        if (!Check(&r, expect, suction, kind)){
+            printf("seed %lu: %s dive, expected path %s, suction flow %u seal %lums\n  ", (unsigned long)(seed + i),
+                   kind_name[kind], expect, Gen_Flow(), (unsigned long)sim_plant.seal_ms);
+            Print_Result("got", &r);
+            failed++;
+            continue;
+        }
+        ok[kind]++;
+        if (suction && kind != GEN_LEAK){
+            suctions[Gen_Flow()]++;
+            suction_sum[Gen_Flow()] += r.on_ms[HAL_SUCTION];
+            if (Gen_Flow() == GEN_FLOW_SEALS){
+                seal_sum += sim_plant.seal_ms;
+                sealed += r.on_ms[HAL_SUCTION] + 2u >= sim_plant.seal_ms;
+                fixed_sealed += GEN_SUCTION_MS >= sim_plant.seal_ms;
+            }
+        }
+    }
+    free(steps.step);
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    secs = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%lu dives, %.0f simulated s in %.2f s (%.0fx real time)\n", (unsigned long)count,
+           simulated / 1000.0, secs, secs > 0 ? simulated / 1000.0 / secs : 0.0);
+    for (i = 0; i < GEN_KINDS; i++){
+        printf("  %-7s %6lu run, %6lu as expected\n", kind_name[i], (unsigned long)runs[i], (unsigned long)ok[i]);
+    }
+    for (i = 0; i < 3u; i++){
+        if (suctions[i]) printf("  suction %-7s %6lu run, mean %.2f s (profile %.2f s)\n", flow_name[i],
+                                (unsigned long)suctions[i], suction_sum[i] / 1000.0 / suctions[i], GEN_SUCTION_MS / 1000.0);
+    }
+    if (suctions[GEN_FLOW_SEALS]) printf("  suction held until the seal: %lu of %lu, the profile alone: %lu, mean seal %.2f s\n",
+                                         (unsigned long)sealed, (unsigned long)suctions[GEN_FLOW_SEALS],
+                                         (unsigned long)fixed_sealed, seal_sum / 1000.0 / suctions[GEN_FLOW_SEALS]);
+    if (ascents){
+        printf("  ascent closed loop: %lu of %lu surfaced, mean %.1f s, max %.1f s, lift valve open %.2f s\n",
+               (unsigned long)surfaced, (unsigned long)ascents, surfaced ? ascent_sum / 1000.0 / surfaced : 0.0,
+               ascent_max / 1000.0, surfaced ? lift_sum / 1000.0 / surfaced : 0.0);
+        printf("  ascent fixed pattern: %lu of %lu surfaced, mean %.1f s, lift valve open %.2f s\n",
+               (unsigned long)fixed_up, (unsigned long)ascents, fixed_up ? fixed_sum / 1000.0 / fixed_up : 0.0,
+               fixed_up ? fixed_open_sum / 1000.0 / fixed_up : 0.0);
+        if (fixed_up) printf("  closed loop on those: mean %.1f s, lift valve open %.2f s\n",
+                             both_sum / 1000.0 / fixed_up, both_lift_sum / 1000.0 / fixed_up);
+    }
+    if (failed) printf("%lu failed, rerun one with -v -n 1 -s <seed>\n", (unsigned long)failed);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv){
+    SIM_STEPS steps = { 0, 0, 0 };
+    SIM_RESULT r;
+    uint32_t count = 0, seed = 1;
+    int opt, status = 0;
+
+    while ((opt = getopt(argc, argv, "vn:s:")) != -1){
+        if (opt == 'v') sim_verbose = 1;
+        else if (opt == 'n') count = (uint32_t)strtoul(optarg, 0, 0);
+        else if (opt == 's') seed = (uint32_t)strtoul(optarg, 0, 0);
+        else {
+            fprintf(stderr, "usage: %s [-v] scenario...\n       %s [-v] -n count [-s seed]\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (count) return Run_Generated(count, seed);
+    if (optind == argc){
+        fprintf(stderr, "no scenario, see trace.h for the format\n");
+        return 2;
+    }
+
+    for (; optind < argc; optind++){
+        steps.count = 0;
+        steps.expect_path[0] = 0;
+        steps.expect_state[0] = 0;
+        steps.expect_download = 0;
+        sim_plant.on = 0;                   // Scenario files carry their own ascent
+        if (!Trace_Load(argv[optind], &steps)){
+            status = 2;
+            continue;
+        }
+        if (!Run_Child(&steps, &r)){
+            printf("%s: crashed\n", argv[optind]);
+            status = 1;
+            continue;
+        }
+        Print_Result(argv[optind], &r);
+        if (!Check_Expect(argv[optind], &steps, &r)) status = 1;
+    }
+    free(steps.step);
+    return status;
+}
+
+/* [] END OF FILE */
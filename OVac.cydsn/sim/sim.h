@@ -0,0 +1,108 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include "hal.h"
+#include "transfer.h"
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+/* Host simulator of the dive controller, see sim.c */
+
+#define SIM_PATH_LEN            16u
+
+#define SIM_FILES               8u          // Files the simulated SD card holds
+
+/* What the simulated peripherals present to the controller, set by the scenario */
+typedef struct SIM_SENSORS{
+    int32_t adc;                            // Pressure, ADC counts
+    HAL_IMU imu;
+}SIM_SENSORS;
+
+/* What one dive did, collected by the simulated peripherals and the runner */
+typedef struct SIM_RESULT{
+    char path[SIM_PATH_LEN + 1];            // States passed through, one letter each (sim.c state_letter)
+    uint8_t state;                          // State at the end
+    uint32_t end_ms;
+    uint32_t on_ms[2];                      // Time each solenoid was on, HAL_SUCTION and HAL_LIFT
+    uint16_t pulses[2];                     // Times each solenoid was switched on
+    uint32_t frames;                        // Frames received from the device
+    uint32_t bad_frames;                    // Frames with a bad CRC or COBS block
+    uint32_t naks;
+    uint32_t log_bytes;                     // Written to the SD log
+    uint32_t ticks_missed;                  // Sample ticks the filters skipped in the last dive (jitter.h)
+    uint32_t interval_max_us;
+    uint32_t ascent_ms;                     // Lift valve first open to the modelled surface, 0 if not reached
+    int32_t ascent_from_cm;                 // Modelled depth the ascent started from
+    uint32_t download_bytes;                // Run bytes the host had at RSP_DATA_END, all matching the card
+    uint8_t download_bad;                   // A chunk failed its CRC or differed from the card, or the end was short
+}SIM_RESULT;
+
+/* A file on the simulated SD card */
+typedef struct SIM_FILE{
+    char name[RUN_FILE_NAME_LEN];           // Empty for a free slot
+    uint8_t *data;
+    uint32_t len, size;
+}SIM_FILE;
+
+/* Ascent model, see plant.c */
+typedef struct SIM_PLANT{
+    uint8_t on;                             // Set by the generator: model the ascent
+    uint8_t active;                         // Taken over the pressure reading from the trace
+    double surface_counts, counts_per_m;
+    double bottom;                          // m
+    double depth;                           // m
+    double v;                               // m/s, up positive
+    double gas;                             // Bag contents, litres at surface pressure
+    uint32_t start_ms, surfaced_ms;
+    uint32_t noise;
+    double flow_hz, flow_amp;               // Vibration of the suction flow, amplitude 0 if it does not show
+    uint32_t seal_ms;                       // Suction valve open time until the cup seals, 0 never
+    uint32_t suction_ms;                    // Suction valve open time so far
+    uint8_t suction_open;
+}SIM_PLANT;
+
+extern uint32_t sim_ms;
+extern SIM_SENSORS sim_sensors;
+extern SIM_RESULT sim_result;
+extern uint8_t sim_verbose;
+
+void Sim_Note(const char *fmt, ...);
+
+/* plant.c */
+extern SIM_PLANT sim_plant;
+
+void Plant_Start(double depth_m);
+
+void Plant_Step(uint8_t valve_open);
+
+int32_t Plant_Counts(void);
+
+void Plant_Suction(uint8_t valve_open);
+
+int16_t Plant_Vibration(void);
+
+uint32_t Plant_Fixed(double depth_m, double bottom_m, uint8_t pulses, uint32_t on_ms, uint32_t off_ms,
+                     uint32_t *open_ms);
+
+/* hal_sim.c */
+void Sim_HalEnd(void);
+
+SIM_FILE *Sim_File(const char *name, uint8_t create);
+
+/* sim_lcd.c */
+extern char sim_lcd[2][17];
+
+uint8_t Sim_LcdChanged(void);
+
+#endif /* _SIM_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,31 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "clock.h"
+
+/* clock.h on simulated time: Sim_Idle calls Clock_Tick once per simulated millisecond, and no time passes
+ * while the controller runs, so Clock_Us is always on a millisecond boundary. */
+
+volatile uint32_t clock_ms = 0;
+
+void Clock_Start(void){
+    clock_ms = 0;
+}
+
+void Clock_Tick(void){
+    clock_ms++;
+}
+
+uint32_t Clock_Us(void){
+    return clock_ms * 1000u;
+}
+
+/* [] END OF FILE */
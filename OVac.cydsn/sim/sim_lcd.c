@@ -0,0 +1,70 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "LiquidCrystal_I2C.h"
+#include "i2c_queue.h"
+#include "sim.h"
+
+/* The LiquidCrystal_I2C and i2c_queue calls display.c makes, onto a 16x2 character screen in RAM */
+
+char sim_lcd[2][17] = { "                ", "                " };
+
+static uint8_t col = 0, row = 0;
+static uint8_t changed = 0;
+
+static void put(uint8_t c){
+    if (row < 2 && col < 16){
+        sim_lcd[row][col] = (char)c;
+        changed = 1;
+    }
+    col++;                                  // The HD44780 moves the cursor on by itself
+}
+
+uint8_t setCursor(uint8_t c, uint8_t r){
+    col = c;
+    row = r;
+    return 1;
+}
+
+void send(uint8_t value, uint8_t mode){
+    if (mode == Rs) put(value);
+    else if (value & LCD_SETDDRAMADDR) setCursor(value & 0x3Fu, (value & 0x40u) ? 1u : 0);
+}
+
+/* The queue never fills here */
+uint8_t sendStream(const uint8_t *values, uint8_t len, uint8_t mode){
+    uint8_t n = len;
+
+    while (len--) send(*values++, mode);
+    return n;
+}
+
+void LCD_print(char word[]){
+    while (*word) send((uint8_t)*word++, Rs);
+}
+
+/* Returns 1 if the screen changed since the last call */
+uint8_t Sim_LcdChanged(void){
+    uint8_t c = changed;
+    changed = 0;
+    return c;
+}
+
+/* The simulated bus is never busy */
+uint8_t I2cQ_Free(uint8_t prio){
+    return I2CQ_LEN;
+}
+
+void I2cQ_Drain(void){
+}
+
+/* [] END OF FILE */
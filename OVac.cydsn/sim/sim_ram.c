@@ -0,0 +1,46 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "ram.h"
+#include "protocol.h"
+
+/* ram.h has nothing to measure on a host: there is no linker script stack, so the marks read zero */
+
+void Ram_Paint(void){
+}
+
+uint32_t Ram_Stack(void){
+    return 0;
+}
+
+uint32_t Ram_Heap(void){
+    return 0;
+}
+
+uint32_t Ram_Free(void){
+    return 0;
+}
+
+static uint8_t report_pending = 0;
+
+void Ram_Request(void){
+    report_pending = 1;
+}
+
+void Ram_Poll(void){
+    if (report_pending && Ram_Report()) report_pending = 0;
+}
+
+uint8_t Ram_Report(void){
+    return Proto_SendText("ram stack 0 of 0 heap 0 of 0 free 0");
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,122 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sched.h"
+
+/* Host test of the scheduler (sched.h) on a virtual clock.
+ *
+ * Each task moves the clock on by its cost when it runs, so execution times, lateness and deadlines are
+ * exact. Checks the order tasks run in, the overrun and miss counters, skipped releases after a long stall,
+ * Sched_Idle, and all of it again across the wrap of the 32 bit microsecond clock.
+ *
+ *   test_sched                         exits 1 if any check fails */
+
+#define ORDER_MAX               32u
+
+static uint32_t now_us;
+static uint32_t cost[3];                    // Run time of each task, us
+static char order[ORDER_MAX + 1];           // Letters of the tasks in the order they ran
+static uint8_t ran = 0;
+static int failures = 0;
+
+static uint32_t Now(void){
+    return now_us;
+}
+
+static void Run(uint8_t i){
+    now_us += cost[i];
+    if (ran < ORDER_MAX) order[ran++] = (char)('a' + i);
+    order[ran] = 0;
+}
+
+static void Task_A(void){ Run(0); }
+static void Task_B(void){ Run(1); }
+static void Task_C(void){ Run(2); }
+
+static void Check(int ok, const char *what){
+    if (ok) return;
+    printf("sched: %s (order \"%s\", clock %lu)\n", what, order, (unsigned long)now_us);
+    failures++;
+}
+
+/* Run everything released, without moving the clock between runs */
+static void Drain(SCHED *s){
+    while (Sched_Run(s));
+}
+
+static void Test(uint32_t start){
+    SCHED s;
+    SCHED_TASK tasks[] = {
+        SCHED_TASK_INIT("c", Task_C, 10000, 10000, 1000),    // Table order is not deadline order
+        SCHED_TASK_INIT("b", Task_B, 2000,  2000,  500),     // Like the filter task
+        SCHED_TASK_INIT("a", Task_A, 2000,  1000,  300),     // and the sample task
+    };
+
+    now_us = start;
+    ran = 0;
+    order[0] = 0;
+    cost[0] = 100;
+    cost[1] = 200;
+    cost[2] = 300;
+    Sched_Init(&s, tasks, 3, Now, start);
+
+    /* All released together: earliest absolute deadline first, whatever the table order */
+    Drain(&s);
+    Check(!strcmp(order, "abc"), "first releases out of deadline order");
+    Check(now_us == start + 600u, "run times not charged to the clock");
+    Check(Sched_Misses(&s) == 0 && tasks[2].overruns == 0, "misses or overruns on time");
+    Check(Sched_Run(&s) == 0, "ran a task before its release");
+    Check(Sched_Idle(&s) == 1400u, "idle time to the next release");
+
+    /* Next period, c is not due */
+    now_us = start + 2000u;
+    ran = 0;
+    Drain(&s);
+    Check(!strcmp(order, "ab"), "second period");
+    Check(tasks[2].runs == 2 && tasks[1].runs == 2 && tasks[0].runs == 1, "run counts");
+
+    /* b overruns its budget but meets its deadline */
+    now_us = start + 4000u;
+    ran = 0;
+    cost[1] = 700;
+    Drain(&s);
+    Check(tasks[1].overruns == 1 && tasks[1].misses == 0, "overrun without a miss");
+    Check(tasks[1].wcet_us == 700, "worst case run time");
+
+    /* a is released late enough to finish after its deadline: one miss, and the release after it is kept */
+    now_us = start + 6950u;
+    ran = 0;
+    cost[1] = 200;
+    Sched_Run(&s);
+    Check(!strcmp(order, "a") && tasks[2].misses == 1, "late finish not a miss");
+    Check(tasks[2].release == start + 8000u, "late task lost its next release");
+    Drain(&s);
+
+    /* A stall over several periods: the lost releases are counted and each task runs once */
+    now_us = start + 16500u;
+    ran = 0;
+    Drain(&s);
+    Check(!strcmp(order, "abc"), "after a stall, each task once in deadline order");
+    Check(tasks[2].misses == 1u + 4u, "releases lost in a stall");
+    Check(tasks[2].release == start + 18000u, "release after a stall");
+    Check(tasks[0].misses == 0 && tasks[0].runs == 2, "task c inside its period");
+}
+
+int main(void){
+    Test(0);
+    Test(0xFFFFF000u);                      // Wraps during the run
+    printf("sched: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,316 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <string.h>
+#include <project.h>
+#include "transfer.h"
+#include "protocol.h"
+
+/* Host test of the run download (transfer.h) over a lossy link, on a virtual millisecond clock.
+ *
+ * The device side is transfer.c on a run file in memory. The link delays every frame by a random time, so
+ * chunks and acks overtake each other, and drops or corrupts some of them. The host side keeps the bytes of
+ * the chunks that arrive in order with a good CRC and acks cumulatively, as the download tool does. Each
+ * download must end in RSP_DATA_END with the host holding exactly the bytes of the file, after any number
+ * of go back resends and window wraps. Also checks resuming from an offset, a missing run, and giving up
+ * on a dead link, including across the wrap of the 32 bit millisecond clock, and the run file names.
+ *
+ *   test_transfer                      exits 1 if any check fails */
+
+#define RUN                     7u
+#define RUN_LEN                 (37u * TRANSFER_CHUNK_LEN + 55u)   // Many windows, a short last chunk
+#define LINK_BYTES              600u        // Frame bytes the link holds before tx_free reports it full
+#define LINK_FRAMES             64u
+#define FRAME_MAX               (PROTO_CHUNK_HDR_LEN + TRANSFER_CHUNK_LEN + 2u)
+#define RUN_MS_MAX              120000u
+
+typedef struct LINK_FRAME{
+    uint32_t due;                           // Delivered at this clock_ms
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t data[FRAME_MAX];
+}LINK_FRAME;
+
+/* One direction of the link: frames in flight, in no particular order */
+typedef struct LINK{
+    LINK_FRAME frame[LINK_FRAMES];
+    uint8_t used[LINK_FRAMES];
+    uint16_t bytes;
+}LINK;
+
+/* How bad the link is, in percent of frames */
+typedef struct LOSS{
+    uint8_t drop_chunk;
+    uint8_t corrupt_chunk;
+    uint8_t drop_ack;
+    uint16_t delay_max;                     // ms, reorders frames sent closer together than this
+}LOSS;
+
+static uint8_t run_file[RUN_LEN];
+static uint8_t opened = 0;
+static uint32_t now_ms;
+static uint32_t rnd = 1u;
+static LOSS loss;
+static LINK down, up;                       // Device to host, host to device
+
+/* Host side */
+static uint8_t got[RUN_LEN];
+static uint32_t got_next;                   // Every byte before this is in got
+static uint32_t end_size;
+static uint8_t ended, naks;
+static int failures = 0;
+
+static void Check(int ok, const char *what){
+    if (ok) return;
+    printf("transfer: %s (host at %lu, clock %lu)\n", what, (unsigned long)got_next, (unsigned long)now_ms);
+    failures++;
+}
+
+/* xorshift32 */
+static uint32_t Random(uint32_t n){
+    rnd ^= rnd << 13;
+    rnd ^= rnd >> 17;
+    rnd ^= rnd << 5;
+    return n ? rnd % n : rnd;
+}
+
+/* The BT link is not used here, bluetooth.c only needs somewhere to put its bytes */
+void UART_WriteTxData(uint8 b){
+}
+
+void Sim_Idle(void){
+}
+
+static int32_t Run_Open(uint16_t run){
+    if (run != RUN) return -1;
+    opened = 1;
+    return RUN_LEN;
+}
+
+static uint16_t Run_Read(uint32_t offset, uint8_t *buf, uint16_t len){
+    Check(opened, "read with no run open");
+    if (offset >= RUN_LEN) return 0;
+    if (len > RUN_LEN - offset) len = (uint16_t)(RUN_LEN - offset);
+    memcpy(buf, &run_file[offset], len);
+    return len;
+}
+
+static void Run_Close(void){
+    opened = 0;
+}
+
+/* Put a frame on the link after a random delay, unless it is lost. A corrupted frame has one bit of its
+ * chunk data flipped. */
+static uint8_t Link_Put(LINK *l, uint8_t cmd, const void *payload, uint8_t len, uint8_t drop, uint8_t corrupt){
+    LINK_FRAME *f;
+    uint8_t i;
+
+    if (Random(100u) < drop) return 1;                  // Lost on the air, the sender cannot tell
+    for (i = 0; i < LINK_FRAMES && l->used[i]; i++);
+    if (i == LINK_FRAMES || len > FRAME_MAX) return 0;
+    f = &l->frame[i];
+    l->used[i] = 1;
+    l->bytes += len;
+    f->due = now_ms + 1u + Random(loss.delay_max + 1u);
+    f->cmd = cmd;
+    f->len = len;
+    memcpy(f->data, payload, len);
+    if (len > PROTO_CHUNK_HDR_LEN + 2u && Random(100u) < corrupt){
+        f->data[PROTO_CHUNK_HDR_LEN + Random(len - PROTO_CHUNK_HDR_LEN - 2u)] ^= 0x10u;
+    }
+    return 1;
+}
+
+/* The next frame due on the link, 0 if none */
+static LINK_FRAME *Link_Get(LINK *l, LINK_FRAME *out){
+    uint8_t i;
+
+    for (i = 0; i < LINK_FRAMES; i++){
+        if (!l->used[i] || (int32_t)(now_ms - l->frame[i].due) < 0) continue;
+        *out = l->frame[i];
+        l->used[i] = 0;
+        l->bytes -= out->len;
+        return out;
+    }
+    return 0;
+}
+
+static uint8_t Device_Send(uint8_t cmd, const void *payload, uint8_t len){
+    if (cmd != RSP_CHUNK) return Link_Put(&down, cmd, payload, len, 0, 0);
+    return Link_Put(&down, cmd, payload, len, loss.drop_chunk, loss.corrupt_chunk);
+}
+
+static uint16_t Device_TxFree(void){
+    return (down.bytes < LINK_BYTES) ? (uint16_t)(LINK_BYTES - down.bytes) : 0;
+}
+
+static const TRANSFER_IO io = { Run_Open, Run_Read, Run_Close, Device_Send, Device_TxFree };
+
+/* Host side: keep chunks that continue what it has, ack what it holds */
+static void Host_Receive(const LINK_FRAME *f){
+    uint8_t ack[PROTO_DATA_ACK_LEN];
+    uint32_t offset;
+    uint16_t n, i, crc = 0xFFFFu;
+
+    switch (f->cmd){
+        case RSP_CHUNK:
+            n = f->len - PROTO_CHUNK_HDR_LEN - 2u;
+            offset = Proto_GetU32(f->data);
+            for (i = 0; i < n; i++) crc = Proto_Crc16(crc, f->data[PROTO_CHUNK_HDR_LEN + i]);
+            if (crc != Proto_GetU16(&f->data[PROTO_CHUNK_HDR_LEN + n])) break;     // Corrupt, wait for the resend
+            if (offset == got_next && offset + n <= RUN_LEN){
+                memcpy(&got[offset], &f->data[PROTO_CHUNK_HDR_LEN], n);
+                got_next += n;
+            }
+            Proto_PutU32(ack, got_next);
+            Link_Put(&up, CMD_DATA_ACK, ack, sizeof(ack), loss.drop_ack, 0);
+            break;
+        case RSP_DATA_END:
+            ended = 1;
+            end_size = Proto_GetU32(f->data);
+            break;
+        case RSP_NAK:
+            naks++;
+            Check(f->data[0] == CMD_DATA && f->data[1] == NAK_VALUE, "NAK payload");
+            break;
+    }
+}
+
+/* Run the link and the device until the transfer stops or ms have passed. A late ack must never take the
+ * window back. */
+static void Run_For(uint32_t ms){
+    LINK_FRAME f;
+    uint32_t stop = now_ms + ms, acked = transfer_stats.bytes_acked;
+
+    while ((int32_t)(now_ms - stop) < 0){
+        now_ms++;
+        while (Link_Get(&up, &f)) Transfer_Ack(Proto_GetU32(f.data));
+        while (Link_Get(&down, &f)) Host_Receive(&f);
+        Transfer_Poll(now_ms);
+        if (transfer_stats.bytes_acked < acked){
+            Check(0, "window went back");
+            return;
+        }
+        acked = transfer_stats.bytes_acked;
+        if (Transfer_State() != TRANSFER_SENDING && !down.bytes && !up.bytes) return;
+    }
+}
+
+static void Reset(uint32_t start, uint8_t drop_chunk, uint8_t corrupt_chunk, uint8_t drop_ack, uint16_t delay_max){
+    memset(&down, 0, sizeof(down));
+    memset(&up, 0, sizeof(up));
+    memset(got, 0, sizeof(got));
+    got_next = 0;
+    ended = 0;
+    end_size = 0;
+    naks = 0;
+    now_ms = start;
+    loss.drop_chunk = drop_chunk;
+    loss.corrupt_chunk = corrupt_chunk;
+    loss.drop_ack = drop_ack;
+    loss.delay_max = delay_max;
+    Transfer_Init(&io);
+}
+
+/* A whole download from offset 0 */
+static void Download(const char *name, uint32_t start, uint8_t drop_chunk, uint8_t corrupt_chunk, uint8_t drop_ack,
+                     uint16_t delay_max){
+    char what[80];
+
+    Reset(start, drop_chunk, corrupt_chunk, drop_ack, delay_max);
+    Transfer_Request(RUN, 0);
+    Run_For(RUN_MS_MAX);
+    snprintf(what, sizeof(what), "%s: did not finish", name);
+    Check(ended && Transfer_State() == TRANSFER_DONE && end_size == RUN_LEN, what);
+    snprintf(what, sizeof(what), "%s: bytes differ", name);
+    Check(got_next == RUN_LEN && !memcmp(got, run_file, RUN_LEN), what);
+    snprintf(what, sizeof(what), "%s: run left open", name);
+    Check(!opened, what);
+}
+
+int main(void){
+    char name[RUN_FILE_NAME_LEN];
+    uint32_t i, resume;
+
+    for (i = 0; i < RUN_LEN; i++) run_file[i] = (uint8_t)(i * 13u + (i >> 8));
+
+    /* Clean link: every chunk once, no timeouts */
+    Download("clean", 0, 0, 0, 0, 0);
+    Check(transfer_stats.chunks_sent == (RUN_LEN + TRANSFER_CHUNK_LEN - 1u) / TRANSFER_CHUNK_LEN &&
+          transfer_stats.chunks_resent == 0 && transfer_stats.timeouts == 0, "clean: resends");
+
+    /* Chunks and acks overtaking each other: late acks are older than what the device has, late chunks are
+     * dropped by the host and sent again */
+    Download("reordered", 0, 0, 0, 0, 40);
+
+    /* Chunks lost, corrupted and reordered, acks lost and reordered: go back and resend */
+    Download("lossy", 0, 10, 5, 20, 40);
+    Check(transfer_stats.chunks_resent > 0 && transfer_stats.timeouts > 0, "lossy: nothing resent");
+
+    /* The same across the wrap of the clock */
+    Download("lossy wrap", 0xFFFFFFFFu - 2000u, 10, 5, 20, 40);
+
+    /* Link drops half way: the host resumes from the offset it reached */
+    Reset(0, 5, 0, 10, 20);
+    Transfer_Request(RUN, 0);
+    Run_For(400);
+    Transfer_Cancel();
+    Run_For(5000);
+    Check(Transfer_State() == TRANSFER_IDLE && !opened, "resume: cancel");
+    resume = got_next;
+    Check(resume > 0 && resume < RUN_LEN, "resume: no partial download");
+    Transfer_Request(RUN, resume);
+    Run_For(RUN_MS_MAX);
+    Check(ended && got_next == RUN_LEN && !memcmp(got, run_file, RUN_LEN), "resume: bytes differ");
+    Check(transfer_stats.bytes_acked == RUN_LEN, "resume: acked");
+
+    /* No such run */
+    Reset(0, 0, 0, 0, 0);
+    Transfer_Request(RUN + 1u, 0);
+    Run_For(100);
+    Check(naks == 1 && Transfer_State() == TRANSFER_FAILED && !ended, "missing run");
+
+    /* Dead link back to the device: gives up after the retries, across the clock wrap */
+    Reset(0xFFFFFFFFu - 3000u, 0, 0, 100, 0);
+    Transfer_Request(RUN, 0);
+    Run_For(RUN_MS_MAX);
+    Check(Transfer_State() == TRANSFER_FAILED && !ended && !opened, "dead link");
+    Check(transfer_stats.timeouts == TRANSFER_MAX_RETRIES + 1u, "dead link: timeouts");
+    Check(now_ms - (0xFFFFFFFFu - 3000u) <= (TRANSFER_MAX_RETRIES + 2u) * TRANSFER_TIMEOUT_MS, "dead link: took too long");
+
+    /* An ack past what was sent does not move the window over data the host never got */
+    Reset(0, 0, 0, 100, 0);
+    Transfer_Request(RUN, 0);
+    Run_For(10);
+    Transfer_Ack(RUN_LEN);
+    Run_For(10);
+    Check(Transfer_State() == TRANSFER_SENDING && !ended && transfer_stats.bytes_acked == 0 &&
+          transfer_stats.acks_rejected == 1, "ack past sent");
+    Transfer_Cancel();
+    Run_For(10);
+
+    /* Run file names, as written and as FAT lists them */
+    Transfer_RunName(name, 42);
+    Check(!strcmp(name, "test42.txt") && Transfer_RunNumber(name) == 42u, "run name");
+    Check(Transfer_RunNumber("TEST7.TXT") == 7u, "upper case run name");
+    Check(!Transfer_RunNumber("test.txt") && !Transfer_RunNumber("test7.txt.bak") &&
+          !Transfer_RunNumber("best7.txt") && !Transfer_RunNumber("test70000.txt") &&
+          !Transfer_RunNumber("test10000.txt"), "not run names");
+    Transfer_RunName(name, 12345);
+    Check(!strcmp(name, "test9999.txt"), "run name past 8.3");
+    Check(Transfer_NextRun(41) == 42u && Transfer_NextRun(TRANSFER_RUN_MAX) == TRANSFER_RUN_MAX, "next run");
+
+    printf("transfer: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,186 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "protocol.h"
+
+typedef struct SIM_COMMAND{
+    const char *name;
+    uint8_t cmd;
+    uint8_t size[2];                        // Payload field sizes, little endian on the wire
+}SIM_COMMAND;
+
+static const SIM_COMMAND commands[] = {
+    { "ping",      CMD_PING,      { 0, 0 } },
+    { "start",     CMD_START,     { 0, 0 } },
+    { "depth",     CMD_DEPTH,     { 2, 0 } },
+    { "reset",     CMD_RESET,     { 0, 0 } },
+    { "data",      CMD_DATA,      { 2, 4 } },
+    { "ack",       CMD_DATA_ACK,  { 4, 0 } },
+    { "telemetry", CMD_TELEMETRY, { 1, 0 } },
+    { "power",     CMD_POWER,     { 0, 0 } },
+};
+
+SIM_STEP *Trace_Push(SIM_STEPS *steps, uint32_t ms, uint8_t kind){
+    SIM_STEP *s;
+
+    if (steps->count == steps->size){
+        steps->size = steps->size ? steps->size * 2u : 256u;
+        steps->step = realloc(steps->step, steps->size * sizeof(SIM_STEP));
+        if (!steps->step){
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+    }
+    s = &steps->step[steps->count];
+    memset(s, 0, sizeof(*s));
+    s->ms = ms;
+    s->seq = steps->count++;
+    s->kind = kind;
+    return s;
+}
+
+static int Step_Order(const void *a, const void *b){
+    const SIM_STEP *x = a, *y = b;
+
+    if (x->ms != y->ms) return (x->ms < y->ms) ? -1 : 1;
+    return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/* Steps in time order, steps at the same time in the order they were pushed */
+void Trace_Sort(SIM_STEPS *steps){
+    qsort(steps->step, steps->count, sizeof(SIM_STEP), Step_Order);
+}
+
+void Trace_Command(SIM_STEPS *steps, uint32_t ms, uint8_t cmd, uint32_t a, uint32_t b){
+    SIM_STEP *s = Trace_Push(steps, ms, STEP_CMD);
+    uint32_t arg[2] = { a, b };
+    uint8_t i, j;
+
+    s->cmd = cmd;
+    for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++){
+        if (commands[i].cmd != cmd) continue;
+        for (j = 0; j < 2u; j++){
+            if (commands[i].size[j] == 1u) s->payload[s->len] = (uint8_t)arg[j];
+            else if (commands[i].size[j] == 2u) Proto_PutU16(&s->payload[s->len], (uint16_t)arg[j]);
+            else if (commands[i].size[j] == 4u) Proto_PutU32(&s->payload[s->len], arg[j]);
+            s->len += commands[i].size[j];
+        }
+    }
+}
+
+/* Parse one line. Returns 0 if it is not understood. */
+static uint8_t Parse_Line(SIM_STEPS *steps, char *line){
+    char word[16];
+    unsigned long ms, a = 0, b = 0;
+    long v[5];
+    int used = 0;
+    char *p = strchr(line, '#');
+    SIM_STEP *s;
+    uint8_t i;
+
+    if (p) *p = 0;
+    if (sscanf(line, " expect %15s %n", word, &used) == 1 && used){
+        p = line + used;
+        if (!strcmp(word, "path")) return sscanf(p, "%15s", steps->expect_path) == 1;
+        if (!strcmp(word, "state")) return sscanf(p, "%15s", steps->expect_state) == 1;
+        if (!strcmp(word, "download")){
+            steps->expect_download = 1;
+            return 1;
+        }
+        return 0;
+    }
+    if (sscanf(line, " %lu %15s %n", &ms, word, &used) < 2){
+        for (p = line; *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'; p++);
+        return *p == 0;                     // Blank line
+    }
+    p = line + used;
+
+    if (!strcmp(word, "imu")){
+        if (sscanf(p, "%ld %ld %ld %ld", &v[0], &v[1], &v[2], &v[3]) != 4) return 0;
+        s = Trace_Push(steps, ms, STEP_IMU);
+        for (i = 0; i < 4u; i++) s->v[i] = v[i];
+        return 1;
+    }
+    if (!strcmp(word, "adc")){
+        if (sscanf(p, "%ld", &v[0]) != 1) return 0;
+        Trace_Push(steps, ms, STEP_ADC)->v[0] = v[0];
+        return 1;
+    }
+    if (!strcmp(word, "sample")){
+        if (sscanf(p, "%ld %ld %ld %ld %ld", &v[0], &v[1], &v[2], &v[3], &v[4]) != 5) return 0;
+        s = Trace_Push(steps, ms, STEP_SAMPLE);
+        for (i = 0; i < 5u; i++) s->v[i] = v[i];
+        return 1;
+    }
+    if (!strcmp(word, "water")){
+        Trace_Push(steps, ms, STEP_WATER);
+        return 1;
+    }
+    if (!strcmp(word, "end")){
+        Trace_Push(steps, ms, STEP_END);
+        return 1;
+    }
+    if (!strcmp(word, "truth")){
+        if (sscanf(p, "%15s", word) != 1) return 0;
+        if (!strcmp(word, "descent")) Trace_Push(steps, ms, STEP_TRUTH)->v[0] = TRUTH_DESCENT;
+        else if (!strcmp(word, "bottom")) Trace_Push(steps, ms, STEP_TRUTH)->v[0] = TRUTH_BOTTOM;
+        else return 0;
+        return 1;
+    }
+    for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++){
+        if (strcmp(word, commands[i].name)) continue;
+        if ((commands[i].size[0] && sscanf(p, "%lu", &a) != 1) ||
+            (commands[i].size[1] && sscanf(p, "%lu %lu", &a, &b) != 2)) return 0;
+        Trace_Command(steps, ms, commands[i].cmd, a, b);
+        return 1;
+    }
+    return 0;
+}
+
+/* Append the steps of a file to steps, in time order. Returns 0 if it could not be read. */
+uint8_t Trace_Load(const char *name, SIM_STEPS *steps){
+    char line[TRACE_LINE_LEN];
+    unsigned n = 0;
+    FILE *f = fopen(name, "r");
+
+    if (!f){
+        perror(name);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f)){
+        n++;
+        if (!Parse_Line(steps, line)){
+            fprintf(stderr, "%s:%u: not understood\n", name, n);
+            fclose(f);
+            return 0;
+        }
+    }
+    fclose(f);
+    Trace_Sort(steps);
+    return 1;
+}
+
+/* xorshift32, the same dive for the same seed on every host */
+uint32_t Trace_Random(uint32_t *s, uint32_t n){
+    uint32_t x = *s;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return n ? x % n : x;
+}
+
+/* [] END OF FILE */
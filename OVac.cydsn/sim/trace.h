@@ -0,0 +1,82 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/* Scenario and recorded dive traces, read by the simulator (sim.c) and the detection benchmark (bench.c).
+ *
+ * One step per line, times in milliseconds, '#' starts a comment:
+ *
+ *   <ms> start | ping | reset | power          Bluetooth command
+ *   <ms> depth <feet>                          CMD_DEPTH
+ *   <ms> telemetry <hz>                        CMD_TELEMETRY
+ *   <ms> data <run> <offset>                   CMD_DATA
+ *   <ms> imu <az> <gx> <gy> <gz>               MPU6050 readings from here on, raw LSBs
+ *   <ms> adc <counts>                          Pressure ADC result from here on
+ *   <ms> sample <counts> <az> <gx> <gy> <gz>   Both, one line of a recorded trace
+ *   <ms> water                                 Moisture comparator trips
+ *   <ms> truth descent | bottom                What really happened, for bench.c; the simulator skips it
+ *   <ms> end                                   Stop, otherwise 60s after the last step
+ *   expect path <letters>                      The states the dive must pass through, sim.c state_letter
+ *   expect state <name>                        The state it must end in, e.g. TRANSMIT
+ *   expect download                            A data step must download its run intact
+ *
+ * The simulator fails a scenario that does not meet its expect lines. */
+
+#define TRACE_LINE_LEN          128u
+#define TRACE_EXPECT_LEN        15u
+
+/* Step kinds */
+#define STEP_CMD                0u
+#define STEP_IMU                1u
+#define STEP_ADC                2u
+#define STEP_SAMPLE             3u
+#define STEP_WATER              4u
+#define STEP_END                5u
+#define STEP_TRUTH              6u
+
+/* STEP_TRUTH v[0] */
+#define TRUTH_DESCENT           0u          // Left the surface
+#define TRUTH_BOTTOM            1u          // Hit the bottom
+
+typedef struct SIM_STEP{
+    uint32_t ms;
+    uint32_t seq;                           // Order in the file, keeps steps at the same time in order
+    uint8_t kind;
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t payload[6];
+    int32_t v[5];
+}SIM_STEP;
+
+typedef struct SIM_STEPS{
+    SIM_STEP *step;
+    uint32_t count, size;
+    char expect_path[TRACE_EXPECT_LEN + 1];     // Empty if the trace does not say
+    char expect_state[TRACE_EXPECT_LEN + 1];
+    uint8_t expect_download;
+}SIM_STEPS;
+
+SIM_STEP *Trace_Push(SIM_STEPS *steps, uint32_t ms, uint8_t kind);
+
+void Trace_Command(SIM_STEPS *steps, uint32_t ms, uint8_t cmd, uint32_t a, uint32_t b);
+
+void Trace_Sort(SIM_STEPS *steps);
+
+uint8_t Trace_Load(const char *name, SIM_STEPS *steps);
+
+uint32_t Trace_Random(uint32_t *s, uint32_t n);
+
+#endif /* _TRACE_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,119 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "solenoid.h"
+#include "hal.h"
+
+typedef struct SOL_CHANNEL{
+    volatile uint8_t duty;
+    uint8_t on;                             // Pin state last written
+    const SOL_STEP *steps;                  // Profile being played, 0 if none
+    uint8_t step;
+    uint32_t left;                          // Milliseconds left in the step
+    volatile uint32_t on_ms;
+}SOL_CHANNEL;
+
+static SOL_CHANNEL channel[SOL_COUNT];
+static uint8_t phase = 0;                   // Millisecond of the PWM period
+
+/* Hold a duty, stopping any profile. 0 closes the valve, SOL_FULL holds it open. */
+void Sol_Set(uint8_t which, uint8_t duty){
+    SOL_CHANNEL *c = &channel[which];
+    uint8_t s = CyEnterCriticalSection();
+
+    c->steps = 0;
+    c->duty = (duty > SOL_FULL) ? SOL_FULL : duty;
+    CyExitCriticalSection(s);
+}
+
+uint8_t Sol_Duty(uint8_t which){
+    return channel[which].duty;
+}
+
+/* Play steps, which must stay in place until the profile is over */
+void Sol_Profile(uint8_t which, const SOL_STEP *steps){
+    SOL_CHANNEL *c = &channel[which];
+    uint8_t s = CyEnterCriticalSection();
+
+    c->steps = steps;
+    c->step = 0;
+    c->left = steps[0].ms;
+    c->duty = c->left ? steps[0].duty : 0u;
+    if (!c->left) c->steps = 0;
+    CyExitCriticalSection(s);
+}
+
+/* Length of a profile in milliseconds */
+uint32_t Sol_ProfileMs(const SOL_STEP *steps){
+    uint32_t ms = 0;
+    uint8_t i;
+
+    for (i = 0; i < SOL_STEPS_MAX && steps[i].ms; i++) ms += steps[i].ms;
+    return ms;
+}
+
+/* Milliseconds left in the profile a solenoid is playing, 0 if none */
+uint32_t Sol_ProfileLeft(uint8_t which){
+    SOL_CHANNEL *c = &channel[which];
+    uint32_t ms = 0;
+    uint8_t i, s = CyEnterCriticalSection();
+
+    if (c->steps){
+        ms = c->left;
+        for (i = c->step + 1u; i < SOL_STEPS_MAX && c->steps[i].ms; i++) ms += c->steps[i].ms;
+    }
+    CyExitCriticalSection(s);
+    return ms;
+}
+
+/* Hold the step a profile is playing for ms longer. Returns 0 if the profile has already ended. */
+uint8_t Sol_Extend(uint8_t which, uint16_t ms){
+    SOL_CHANNEL *c = &channel[which];
+    uint8_t ok, s = CyEnterCriticalSection();
+
+    ok = c->steps != 0;
+    if (ok) c->left += ms;
+    CyExitCriticalSection(s);
+    return ok;
+}
+
+uint32_t Sol_OnMs(uint8_t which){
+    return channel[which].on_ms;
+}
+
+/* Move each profile on and switch the pins for this millisecond of the period. Called every 1ms. */
+void Sol_Tick(void){
+    SOL_CHANNEL *c;
+    uint8_t i, on;
+
+    for (i = 0; i < SOL_COUNT; i++){
+        c = &channel[i];
+        on = phase < c->duty;
+        if (on != c->on){
+            c->on = on;
+            Hal_Solenoid(i, on);
+        }
+        if (on) c->on_ms++;
+        if (c->steps && --c->left == 0){
+            if (++c->step < SOL_STEPS_MAX && c->steps[c->step].ms){
+                c->left = c->steps[c->step].ms;
+                c->duty = c->steps[c->step].duty;
+            } else {
+                c->steps = 0;
+                c->duty = 0;
+            }
+        }
+    }
+    if (++phase >= SOL_PERIOD_MS) phase = 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _SOLENOID_H_
+#define _SOLENOID_H_
+
+/* Solenoid valve PWM.
+ *
+ * Each solenoid (HAL_SUCTION, HAL_LIFT) is held open for duty milliseconds out of every SOL_PERIOD_MS, so
+ * the gas let into the lift bag can be metered rather than only switched. Sol_Tick runs the modulation from
+ * the 1ms countdown ISR (Sim_Idle in the simulator) and switches the pins through Hal_Solenoid. This is
+ * software PWM on a 1ms tick, so the duty resolution is one tick: 1ms of the 100ms period, which is one
+ * step of SOL_FULL. The valves take a few milliseconds to move, so an opening or a closing shorter than
+ * SOL_DUTY_MIN is not followed. Closed loop users (ascent.c) keep duties at 0, SOL_FULL, or between
+ * SOL_DUTY_MIN and SOL_FULL - SOL_DUTY_MIN.
+ *
+ * A solenoid can also play a profile: up to SOL_STEPS_MAX steps of a duty held for a time, after which it
+ * closes. The suction cycle in LANDED is one, set over Bluetooth with CMD_SUCTION, and Sol_Extend lets it
+ * run on while the flow says it is still needed (suction.h).
+ *
+ * Sol_OnMs counts the time each valve has been open, which for the lift bag is the gas used. */
+
+#define SOL_COUNT               2u          // HAL_SUCTION, HAL_LIFT
+#define SOL_PERIOD_MS           100u
+#define SOL_FULL                100u        // Duty of a valve held open
+#define SOL_DUTY_MIN            10u         // Shortest opening or closing the valves follow, 10ms
+#define SOL_STEPS_MAX           4u
+
+#if SOL_PERIOD_MS != SOL_FULL
+#error "Sol_Tick compares the 1ms phase with the duty, one duty step must be one tick"
+#endif
+
+#define PROTO_SUCTION_LEN       (SOL_STEPS_MAX * 3u)    // CMD_SUCTION: SOL_STEPS_MAX of duty:u8, ms:u16
+
+typedef struct SOL_STEP{
+    uint8_t duty;                           // 0 to SOL_FULL
+    uint16_t ms;                            // 0 ends the profile
+}SOL_STEP;
+
+void Sol_Set(uint8_t which, uint8_t duty);
+
+uint8_t Sol_Duty(uint8_t which);
+
+void Sol_Profile(uint8_t which, const SOL_STEP *steps);
+
+uint32_t Sol_ProfileMs(const SOL_STEP *steps);
+
+uint32_t Sol_ProfileLeft(uint8_t which);
+
+uint8_t Sol_Extend(uint8_t which, uint16_t ms);
+
+uint32_t Sol_OnMs(uint8_t which);
+
+void Sol_Tick(void);
+
+#endif /* _SOLENOID_H_ */
+/* [] END OF FILE */
@@ -0,0 +1,169 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "spectrum.h"
+
+#define SPEC_MASK               (SPEC_FFT_N - 1u)
+
+/* cos(2 pi k / SPEC_FFT_N) in q15, 1 held at 32767 */
+static const int16_t spec_cos[SPEC_FFT_N] = {
+     32767,  32610,  32138,  31357,  30274,  28899,  27246,  25330,
+     23170,  20788,  18205,  15447,  12540,   9512,   6393,   3212,
+         0,  -3212,  -6393,  -9512, -12540, -15447, -18205, -20788,
+    -23170, -25330, -27246, -28899, -30274, -31357, -32138, -32610,
+    -32768, -32610, -32138, -31357, -30274, -28899, -27246, -25330,
+    -23170, -20788, -18205, -15447, -12540,  -9512,  -6393,  -3212,
+         0,   3212,   6393,   9512,  12540,  15447,  18205,  20788,
+     23170,  25330,  27246,  28899,  30274,  31357,  32138,  32610
+};
+
+/* Bit reversed indices, the input order of the FFT */
+static const uint8_t spec_rev[SPEC_FFT_N] = {
+     0, 32, 16, 48,  8, 40, 24, 56,  4, 36, 20, 52, 12, 44, 28, 60,
+     2, 34, 18, 50, 10, 42, 26, 58,  6, 38, 22, 54, 14, 46, 30, 62,
+     1, 33, 17, 49,  9, 41, 25, 57,  5, 37, 21, 53, 13, 45, 29, 61,
+     3, 35, 19, 51, 11, 43, 27, 59,  7, 39, 23, 55, 15, 47, 31, 63
+};
+
+static int16_t re[SPEC_FFT_N], im[SPEC_FFT_N];
+
+void Spec_Clear(SPEC_WINDOW *w){
+    w->head = 0;
+    w->full = 0;
+    w->fresh = 0;
+    w->held = 0;
+}
+
+/* One sample of each axis, held if it repeats the last reading for want of a new one */
+void Spec_Push(SPEC_WINDOW *w, int16_t az, int16_t gx, int16_t gy, uint8_t held){
+    w->x[SPEC_AZ][w->head] = az;
+    w->x[SPEC_GX][w->head] = gx;
+    w->x[SPEC_GY][w->head] = gy;
+    w->head = (w->head + 1u) & SPEC_MASK;
+    if (!w->head) w->full = 1;
+    if (held){
+        w->held++;
+        w->fresh = 0;
+    } else if (w->fresh < SPEC_FFT_N){
+        w->fresh++;
+    }
+}
+
+/* Returns 1 if the window is full and every sample in it is a new reading */
+uint8_t Spec_Ready(const SPEC_WINDOW *w){
+    return w->full && w->fresh >= SPEC_FFT_N;
+}
+
+/* In place, re and im in bit reversed order. Out: the DFT / SPEC_FFT_N. */
+static void Fft(void){
+    uint16_t size, half, step, i, j, a, b;
+    int32_t wr, ws, tr, ti;
+
+    for (size = 2u, step = SPEC_FFT_N / 2u; size <= SPEC_FFT_N; size <<= 1, step >>= 1){
+        half = size >> 1;
+        for (j = 0; j < half; j++){
+            wr = spec_cos[j * step];                                // W = cos - i sin
+            ws = spec_cos[(j * step + SPEC_FFT_N * 3u / 4u) & SPEC_MASK];
+            for (i = j; i < SPEC_FFT_N; i += size){
+                a = i;
+                b = i + half;
+                tr = (wr * re[b] + ws * im[b]) >> 15;
+                ti = (wr * im[b] - ws * re[b]) >> 15;
+                re[b] = (int16_t)((re[a] - tr) >> 1);
+                im[b] = (int16_t)((im[a] - ti) >> 1);
+                re[a] = (int16_t)((re[a] + tr) >> 1);
+                im[a] = (int16_t)((im[a] + ti) >> 1);
+            }
+        }
+    }
+}
+
+/* Power of bins 0 to SPEC_FFT_N/2 - 1 of one axis of a full window, oldest sample first */
+void Spec_Fft(const SPEC_WINDOW *w, uint8_t axis, uint32_t *power){
+    const int16_t *x = w->x[axis];
+    int32_t mean = 0, v;
+    uint16_t n, at;
+
+    for (n = 0; n < SPEC_FFT_N; n++) mean += x[n];
+    mean /= (int32_t)SPEC_FFT_N;
+    for (n = 0; n < SPEC_FFT_N; n++){
+        at = (w->head + spec_rev[n]) & SPEC_MASK;
+        v = x[at] - mean;
+        if (v > 32767) v = 32767;
+        if (v < -32768) v = -32768;
+        re[n] = (int16_t)((v * ((32768 - spec_cos[spec_rev[n]]) >> 1)) >> 15);    // Hann
+        im[n] = 0;
+    }
+    Fft();
+    for (n = 0; n < SPEC_FFT_N / 2u; n++) power[n] = (uint32_t)(re[n] * re[n]) + (uint32_t)(im[n] * im[n]);
+}
+
+/* Bin of the most power from first to last, with that power in *peak */
+uint8_t Spec_Peak(const uint32_t *power, uint8_t first, uint8_t last, uint32_t *peak){
+    uint8_t k, bin = first;
+
+    for (k = first + 1u; k <= last; k++) if (power[k] > power[bin]) bin = k;
+    *peak = power[bin];
+    return bin;
+}
+
+/* Power from bin first to last */
+uint32_t Spec_Band(const uint32_t *power, uint8_t first, uint8_t last){
+    uint32_t sum = 0;
+    uint8_t k;
+
+    for (k = first; k <= last; k++) sum += power[k];
+    return sum;
+}
+
+void Spec_GoertzelReset(SPEC_GOERTZEL *g, uint8_t first, uint8_t bins){
+    uint8_t i;
+
+    for (i = 0; i < SPEC_GOERTZEL_BINS; i++){
+        g->s1[i] = 0;
+        g->s2[i] = 0;
+    }
+    g->first = first;
+    g->bins = (bins > SPEC_GOERTZEL_BINS) ? SPEC_GOERTZEL_BINS : bins;
+    g->n = 0;
+    g->energy = 0;
+}
+
+/* One sample. Returns 1 when it completes a block, with the band energy in g->energy. */
+uint8_t Spec_Goertzel(SPEC_GOERTZEL *g, int16_t x){
+    int32_t s, s1, s2, coeff;
+    int64_t power;
+    uint32_t energy = 0;
+    uint8_t i;
+
+    for (i = 0; i < g->bins; i++){
+        coeff = spec_cos[((g->first + i) * (SPEC_FFT_N / SPEC_BLOCK)) & SPEC_MASK];
+        s = x + (int32_t)(((int64_t)coeff * g->s1[i]) >> 14) - g->s2[i];
+        g->s2[i] = g->s1[i];
+        g->s1[i] = s;
+    }
+    if (++g->n < SPEC_BLOCK) return 0;
+
+    for (i = 0; i < g->bins; i++){
+        coeff = spec_cos[((g->first + i) * (SPEC_FFT_N / SPEC_BLOCK)) & SPEC_MASK];
+        s1 = g->s1[i];
+        s2 = g->s2[i];
+        power = (int64_t)s1 * s1 + (int64_t)s2 * s2 - ((coeff * (int64_t)s1 >> 14) * s2);
+        if (power > 0) energy += (uint32_t)(power >> SPEC_POWER_SHIFT);
+        g->s1[i] = 0;
+        g->s2[i] = 0;
+    }
+    g->n = 0;
+    g->energy = energy;
+    return 1;
+}
+
+/* [] END OF FILE */
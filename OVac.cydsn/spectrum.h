@@ -0,0 +1,83 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _SPECTRUM_H_
+#define _SPECTRUM_H_
+
+/* Spectral analysis of the IMU samples, for pump vibration and impacts.
+ *
+ * The sample task pushes each 2ms reading of az, gx and gy into a SPEC_WINDOW, a sliding window of the last
+ * SPEC_FFT_N. A reading held over because the new one was not in yet is pushed marked held, to keep the
+ * sample rate; it is counted, and Spec_Ready is false until it has left the window, so no FFT is taken over
+ * sample and hold steps. Spec_Fft takes one axis of it with the mean removed through a Hann window and a q15 radix-2
+ * FFT, halving every stage so it cannot overflow, and gives the power of bins 0 to SPEC_FFT_N/2 - 1; bin k
+ * is k * SPEC_SAMPLE_HZ / SPEC_FFT_N Hz. Spec_Peak and Spec_Band read the result. One FFT is a few thousand
+ * cycles, so it runs from a background task (dive.c), on az only and only while the suction is open; on its
+ * own data only, so the sample task is never held up by it. The work buffers are static: one caller at a time.
+ *
+ * Spec_Goertzel is the streaming alternative when only a few bins matter: one call per sample runs a
+ * Goertzel filter for each of up to SPEC_GOERTZEL_BINS adjacent bins of a SPEC_BLOCK sample block, and at
+ * the end of each block sums their power into the band energy. Adjacent bins catch a tone anywhere in the
+ * band within half a bin of one of them. Filter state is 32 bit with 64 bit products, and the power is
+ * scaled down by SPEC_POWER_SHIFT to fit 32 bits at full scale.
+ *
+ * Both take their twiddles and coefficients from one table in flash, cos(2 pi k / SPEC_FFT_N) in q15;
+ * 2cos(2 pi k / SPEC_BLOCK) in Q14, the Goertzel coefficient, is the same number. Timed per window by the
+ * BENCHMARK build on the board and by sim/bench.c on the host. */
+
+#define SPEC_SAMPLE_HZ          500u        // Sample_Timer rate
+#define SPEC_FFT_N              64u         // Window, 128ms, 7.8Hz bins
+#define SPEC_FFT_LOG2           6u
+#define SPEC_BLOCK              32u         // Goertzel block, 64ms, 15.6Hz bins
+#define SPEC_GOERTZEL_BINS      8u
+#define SPEC_POWER_SHIFT        10u
+
+/* Axes of the window */
+#define SPEC_AZ                 0u
+#define SPEC_GX                 1u
+#define SPEC_GY                 2u
+#define SPEC_AXES               3u
+
+typedef struct SPEC_WINDOW{
+    int16_t x[SPEC_AXES][SPEC_FFT_N];
+    uint8_t head;                           // Next slot, the oldest sample once full
+    uint8_t full;
+    uint8_t fresh;                          // Samples pushed since the last held one, up to SPEC_FFT_N
+    uint32_t held;                          // Held samples pushed since Spec_Clear
+}SPEC_WINDOW;
+
+typedef struct SPEC_GOERTZEL{
+    int32_t s1[SPEC_GOERTZEL_BINS], s2[SPEC_GOERTZEL_BINS];   // The last two outputs of each bin
+    uint8_t first, bins;                    // Bins first to first + bins - 1 of SPEC_BLOCK
+    uint8_t n;                              // Samples in the block so far
+    uint32_t energy;                        // Band energy of the last complete block
+}SPEC_GOERTZEL;
+
+void Spec_Clear(SPEC_WINDOW *w);
+
+void Spec_Push(SPEC_WINDOW *w, int16_t az, int16_t gx, int16_t gy, uint8_t held);
+
+uint8_t Spec_Ready(const SPEC_WINDOW *w);
+
+void Spec_Fft(const SPEC_WINDOW *w, uint8_t axis, uint32_t *power);
+
+uint8_t Spec_Peak(const uint32_t *power, uint8_t first, uint8_t last, uint32_t *peak);
+
+uint32_t Spec_Band(const uint32_t *power, uint8_t first, uint8_t last);
+
+void Spec_GoertzelReset(SPEC_GOERTZEL *g, uint8_t first, uint8_t bins);
+
+uint8_t Spec_Goertzel(SPEC_GOERTZEL *g, int16_t x);
+
+#endif /* _SPECTRUM_H_ */
+/* [] END OF FILE */
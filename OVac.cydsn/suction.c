@@ -0,0 +1,73 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "suction.h"
+
+/* On landing, start learning the settled level */
+void Suc_Reset(SUCTION *s){
+    Spec_GoertzelReset(&s->band, SUC_BIN_FIRST, SUC_BINS);
+    s->settled = 0;
+    s->peak = 0;
+    s->ms = 0;
+    s->open = 0;
+    s->flowing = 0;
+    s->loud = 0;
+    s->quiet = 0;
+}
+
+/* The suction valve has opened */
+void Suc_Open(SUCTION *s){
+    s->open = 1;
+    s->ms = 0;
+    s->peak = 0;
+    s->flowing = 0;
+    s->loud = 0;
+    s->quiet = 0;
+}
+
+uint8_t Suc_Sample(SUCTION *s, int16_t az){
+    uint32_t energy, floor;
+
+    if (s->open) s->ms += SUC_SAMPLE_MS;
+    if (!Spec_Goertzel(&s->band, az)) return SUC_RUNNING;
+    energy = s->band.energy;
+    if (!s->open){
+        if (!s->settled) s->settled = energy;
+        else s->settled += (energy >> SUC_SETTLE_SHIFT) - (s->settled >> SUC_SETTLE_SHIFT);
+        if (!s->settled) s->settled = 1;
+        return SUC_RUNNING;
+    }
+
+    if (energy > s->peak) s->peak = energy;
+    if (energy / SUC_FLOW_X > s->settled){
+        if (s->loud < SUC_FLOW_BLOCKS) s->loud++;
+        if (s->loud == SUC_FLOW_BLOCKS) s->flowing = 1;
+        s->quiet = 0;
+        return SUC_RUNNING;
+    }
+    s->loud = 0;
+    if (!s->flowing) return SUC_RUNNING;
+    floor = s->peak >> SUC_SEAL_SHIFT;
+    if (floor < s->settled << SUC_QUIET_SHIFT) floor = s->settled << SUC_QUIET_SHIFT;
+    if (energy > floor){
+        s->quiet = 0;
+        return SUC_RUNNING;
+    }
+    if (s->quiet < SUC_QUIET_BLOCKS) s->quiet++;
+    return (s->quiet == SUC_QUIET_BLOCKS && s->ms >= SUC_MIN_MS) ? SUC_SETTLED : SUC_RUNNING;
+}
+
+/* Water still flowing: flow seen and not settled since */
+uint8_t Suc_Flowing(const SUCTION *s){
+    return s->flowing && s->quiet < SUC_QUIET_BLOCKS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,71 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+#include "spectrum.h"
+
+#ifndef _SUCTION_H_
+#define _SUCTION_H_
+
+/* Suction length from the vibration of the flow, one call per 2ms sample in LANDED.
+ *
+ * While water is drawn through the cup the flow shakes the housing, which shows in the z acceleration as
+ * band energy (spectrum.h) well over what the device has while it settles. Once the cup seals or the
+ * reservoir is spent the flow stops and the energy falls back; holding the valve open after that gains
+ * nothing. Suc_Sample learns the settled level from the blocks before Suc_Open, and after it:
+ *  - SUC_FLOW_BLOCKS blocks in a row over SUC_FLOW_X times the settled level mean water is flowing,
+ *  - then SUC_QUIET_BLOCKS in a row back under 2^SUC_QUIET_SHIFT times it, or under 1/2^SUC_SEAL_SHIFT of
+ *    the peak, with at least SUC_MIN_MS open, mean it has stopped: SUC_SETTLED, end the suction early,
+ *  - still flowing SUC_LEAD_MS before the end of the suction profile means it needs longer: the caller
+ *    extends it by SUC_EXTEND_MS at a time up to SUC_MAX_MS in all.
+ * Single blocks are noisy, hence the runs of them. If no flow shows at all the vibration says nothing about
+ * the suction, and the profile runs as set. The thresholds were tuned on the flow model in the host
+ * simulator (sim/plant.c). */
+
+#define SUC_SAMPLE_MS           2u          // 1000 / SPEC_SAMPLE_HZ
+#define SUC_BIN_FIRST           4u          // 62.5Hz
+#define SUC_BINS                5u          // to 125Hz
+#define SUC_SETTLE_SHIFT        2u          // Settled level filter, 1/4 of each block
+#define SUC_FLOW_X              4u
+#define SUC_FLOW_BLOCKS         2u
+#define SUC_QUIET_SHIFT         1u
+#define SUC_SEAL_SHIFT          3u
+#define SUC_QUIET_BLOCKS        4u          // 256ms
+#define SUC_MIN_MS              500u
+#define SUC_LEAD_MS             200u        // Before the end of the profile, time to decide on extending it
+#define SUC_EXTEND_MS           1000u
+#define SUC_MAX_MS              10000u
+
+/* Suc_Sample results */
+#define SUC_RUNNING             0u
+#define SUC_SETTLED             1u
+
+typedef struct SUCTION{
+    SPEC_GOERTZEL band;
+    uint32_t settled;                       // Band energy before the valve opened
+    uint32_t peak;                          // Highest since it opened
+    uint32_t ms;                            // Valve open, counted in samples
+    uint8_t open;
+    uint8_t flowing;                        // Flow seen since it opened
+    uint8_t loud;                           // Blocks in a row over the flow level
+    uint8_t quiet;                          // Blocks in a row back under it
+}SUCTION;
+
+void Suc_Reset(SUCTION *s);
+
+void Suc_Open(SUCTION *s);
+
+uint8_t Suc_Sample(SUCTION *s, int16_t az);
+
+uint8_t Suc_Flowing(const SUCTION *s);
+
+#endif /* _SUCTION_H_ */
+/* [] END OF FILE */
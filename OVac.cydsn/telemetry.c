@@ -0,0 +1,63 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "telemetry.h"
+#include "protocol.h"
+
+static volatile uint16_t period_ms = 0;     // 0 when the stream is off
+static uint32_t next_ms = 0;
+static uint16_t seq = 0;
+
+/* Set the frame rate, returns 0 if the rate is out of range. Safe to call from the RX interrupt. */
+uint8_t Telemetry_SetRate(uint8_t rate_hz){
+    if (rate_hz == 0){
+        period_ms = 0;
+        return 1;
+    }
+    if (rate_hz < TELEMETRY_MIN_HZ || rate_hz > TELEMETRY_MAX_HZ) return 0;
+    period_ms = 1000u / rate_hz;
+    return 1;
+}
+
+/* Returns 1 when a frame should be sent now. Cheap enough to call every loop iteration. */
+uint8_t Telemetry_Due(uint32_t now_ms){
+    uint16_t period = period_ms;
+
+    if (period == 0) return 0;
+    if ((int32_t)(now_ms - next_ms) < 0) return 0;
+
+    next_ms += period;
+    if ((int32_t)(now_ms - next_ms) >= 0) next_ms = now_ms + period;   // Fell behind, don't burst to catch up
+    return 1;
+}
+
+void Telemetry_Send(const TELEMETRY_SAMPLE *s){
+    uint8_t f[TELEMETRY_FRAME_LEN];
+
+    Proto_PutU16(&f[0], seq++);
+    f[2] = s->state;
+    Proto_PutU16(&f[3], (uint16_t)s->accel_z);
+    Proto_PutU16(&f[5], (uint16_t)s->tilt_x);
+    Proto_PutU16(&f[7], (uint16_t)s->tilt_y);
+    Proto_PutU16(&f[9], (uint16_t)s->depth_cm);
+    Proto_PutU16(&f[11], s->pressure_mv);
+    Proto_PutU16(&f[13], s->loops);
+    Proto_PutU16(&f[15], s->loop_max_us);
+    Proto_PutU16(&f[17], s->latency_max_us);
+    Proto_PutU16(&f[19], s->misses);
+    Proto_PutU32(&f[21], s->ticks);
+    Proto_PutU16(&f[25], s->ticks_missed);
+    Proto_PutU16(&f[27], s->interval_max_us);
+
+    Proto_Send(RSP_TELEMETRY, f, sizeof(f));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,56 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+/* Live telemetry over Bluetooth while the device is at the surface (WAIT_TO_LAUNCH, RESURFACE, TRANSMIT).
+ * Frames are RSP_TELEMETRY messages with a fixed TELEMETRY_FRAME_LEN byte little endian payload, built from
+ * the filter outputs the main loop already keeps, so sending one costs no sensor reads. */
+
+#define TELEMETRY_MIN_HZ        1u
+#define TELEMETRY_MAX_HZ        50u
+#define TELEMETRY_DEFAULT_HZ    0u          // Off until the host asks for it
+
+typedef struct TELEMETRY_SAMPLE{
+    uint8_t state;                          // STATES value
+    int16_t accel_z;                        // Moving average Z acceleration, raw LSB
+    int16_t tilt_x;                         // Moving average X rotation, raw gyro LSB
+    int16_t tilt_y;                         // Moving average Y rotation, raw gyro LSB
+    int16_t depth_cm;                       // Depth estimate from the pressure moving average
+    uint16_t pressure_mv;                   // Pressure sensor moving average, millivolts
+    uint16_t loops;                         // Events run since the previous frame
+    uint16_t loop_max_us;                   // Longest event run to completion since the previous frame
+    uint16_t latency_max_us;                // Longest wait from an ISR posting an event to its dispatch
+    uint16_t misses;                        // Scheduler deadline misses since boot, all tasks
+    uint32_t ticks;                         // Sample_Timer ticks since boot
+    uint16_t ticks_missed;                  // Sample ticks the filters skipped since launch, see jitter.h
+    uint16_t interval_max_us;               // Longest time between sample task runs since launch
+}TELEMETRY_SAMPLE;
+
+/* seq:u16 state:u8 accel_z:i16 tilt_x:i16 tilt_y:i16 depth_cm:i16 pressure_mv:u16 loops:u16 loop_max_us:u16
+ * latency_max_us:u16 misses:u16 ticks:u32 ticks_missed:u16 interval_max_us:u16 */
+#define TELEMETRY_FRAME_LEN     29u
+
+typedef struct PROTO_TELEMETRY_CFG{
+    uint8_t rate_hz;                        // 0 stops the stream, otherwise 1-50
+}PROTO_TELEMETRY_CFG;
+
+uint8_t Telemetry_SetRate(uint8_t rate_hz);
+
+uint8_t Telemetry_Due(uint32_t now_ms);
+
+void Telemetry_Send(const TELEMETRY_SAMPLE *s);
+
+#endif /* _TELEMETRY_H_ */
+/* [] END OF FILE */
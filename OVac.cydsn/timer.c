@@ -0,0 +1,74 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include "timer.h"
+#include "events.h"
+#include "clock.h"
+
+static SOFT_TIMER timers[TIMER_SLOTS];
+
+static void arm(uint8_t id, uint32_t ms, uint32_t period, uint8_t event){
+    SOFT_TIMER *t;
+    uint8_t s;
+
+    if (id >= TIMER_SLOTS) return;
+    t = &timers[id];
+    s = CyEnterCriticalSection();           // Timer_Tick reads the slot from the countdown ISR
+    t->due = clock_ms + ms;
+    t->period = period;
+    t->event = event;
+    t->seq++;
+    t->active = 1;
+    CyExitCriticalSection(s);
+}
+
+/* Fire event once, ms milliseconds from now */
+void Timer_Start(uint8_t id, uint32_t ms, uint8_t event){
+    arm(id, ms, 0, event);
+}
+
+/* Fire event every ms milliseconds, the first time ms from now */
+void Timer_Every(uint8_t id, uint32_t ms, uint8_t event){
+    arm(id, ms, ms, event);
+}
+
+void Timer_Stop(uint8_t id){
+    uint8_t s;
+
+    if (id >= TIMER_SLOTS) return;
+    s = CyEnterCriticalSection();
+    timers[id].active = 0;
+    timers[id].seq++;                       // Anything it already queued is stale now
+    CyExitCriticalSection(s);
+}
+
+/* Returns 1 if an event with this arg came from the timer's latest start */
+uint8_t Timer_Current(uint8_t id, uint16_t arg){
+    if (id >= TIMER_SLOTS) return 0;
+    return timers[id].seq == arg;
+}
+
+/* Called from the countdown ISR every millisecond with the new clock_ms */
+void Timer_Tick(uint32_t now){
+    SOFT_TIMER *t;
+    uint8_t i;
+
+    for (i = 0; i < TIMER_SLOTS; i++){
+        t = &timers[i];
+        if (!t->active || (int32_t)(now - t->due) < 0) continue;
+        if (!Event_Post(t->event, t->seq)) continue;   // Queue full, still due next tick
+        if (t->period) t->due += t->period;
+        else t->active = 0;
+    }
+}
+
+/* [] END OF FILE */
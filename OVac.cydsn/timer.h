@@ -0,0 +1,49 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+/* Software timers on the 1ms clock.
+ *
+ * A timer posts its event to the event queue when it expires, so a wait in the state machine is a state
+ * that handles the event rather than a CyDelay. One-shot timers fire once, periodic ones every period from
+ * when they were started, without drift. Timer_Tick runs them from the countdown ISR.
+ *
+ * Each start or stop bumps the timer's sequence number, which is posted as the event's arg. A timer stopped
+ * or restarted after its event was queued leaves a stale event behind; Timer_Current tells the two apart,
+ * which makes it a ready made FSM guard. If the queue is full the timer stays due and retries on the next
+ * tick, so an expiry is late rather than lost. */
+
+#define TIMER_SLOTS             4u          // Timer ids 0 to TIMER_SLOTS-1, owned by the application
+
+typedef struct SOFT_TIMER{
+    uint32_t due;                           // clock_ms to fire at
+    uint32_t period;                        // Milliseconds, 0 for one-shot
+    uint16_t seq;                           // Bumped by every start and stop
+    uint8_t event;
+    uint8_t active;
+}SOFT_TIMER;
+
+void Timer_Start(uint8_t id, uint32_t ms, uint8_t event);
+
+void Timer_Every(uint8_t id, uint32_t ms, uint8_t event);
+
+void Timer_Stop(uint8_t id);
+
+uint8_t Timer_Current(uint8_t id, uint16_t arg);
+
+void Timer_Tick(uint32_t now);
+
+#endif /* _TIMER_H_ */
+/* [] END OF FILE */
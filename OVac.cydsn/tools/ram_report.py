@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""RAM budget of a build, from the GNU ld map PSoC Creator writes next to the .elf.
+
+    tools/ram_report.py ARM_GCC_493/Debug/OVac.map [--top N] [--min-free BYTES] [--out FILE]
+
+Lists the SRAM sections (.ramvectors, .noinit, .data, .bss, and the .heap and .stack reservations from
+cm3gcc.ld), the object files and the symbols taking the most static RAM, and what is left. With --min-free
+it exits 1 when less than that is left, so a build that eats into the margin fails. With --out the report
+also goes to FILE.
+
+OVac.cyprj runs it as the post build command of both ARM GCC configurations (Build Settings, User Commands),
+with --min-free 2048 and the report in OVac_ram.txt next to the map, so every build prints and keeps its RAM
+budget. Python 3 has to be on the PATH of PSoC Creator.
+
+Static (file local) variables are not in the map, so a symbol's size runs to the next one listed and takes
+in any statics after it; the per object totals are exact.
+
+The stack figure is only the reservation (CYDEV_STACK_SIZE). What the firmware really uses comes from the
+painted stack on the board, see ram.h and CMD_RAM.
+"""
+import argparse
+import collections
+import os
+import re
+import sys
+
+STATIC = ('.ramvectors', '.noinit', '.data', '.bss')
+RESERVED = ('.heap', '.stack')
+
+MEMORY = re.compile(r'^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+OUTPUT = re.compile(r'^(\.[\w.]+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+INPUT = re.compile(r'^ (\.[\w.$]+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$')
+INPUT_WRAPPED = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+SYMBOL = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_][\w.$]*)\s*$')
+
+
+def object_name(path):
+    """Basename of an object, with the archive member for library objects: 'libg_nano.a(lib_a-impure.o)'."""
+    path = path.strip().replace('\\', '/')
+    return os.path.basename(path)
+
+
+def parse(lines):
+    ram = None
+    sections = collections.OrderedDict()        # name -> (address, size)
+    objects = collections.Counter()             # object -> bytes of static RAM
+    symbols = []                                # (size, name, object)
+
+    in_memory = False
+    current = None                              # Output section being read, if in RAM
+    pending = None                              # Input section name waiting for its wrapped line
+    block = None                                # (address, size, object, [(address, symbol)])
+
+    def close_block():
+        if not block:
+            return
+        address, size, obj, syms = block
+        syms.sort()
+        for i, (addr, name) in enumerate(syms):
+            end = syms[i + 1][0] if i + 1 < len(syms) else address + size
+            if end > addr:
+                symbols.append((end - addr, name, obj))
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if line.startswith('Memory Configuration'):
+            in_memory = True
+            continue
+        if in_memory:
+            m = MEMORY.match(line)
+            if m and m.group(1) == 'ram':
+                ram = (int(m.group(2), 16), int(m.group(3), 16))
+            if line.startswith('Linker script and memory map'):
+                in_memory = False
+            continue
+        if ram is None:
+            continue
+
+        m = OUTPUT.match(line)
+        if m:
+            close_block()
+            block = None
+            pending = None
+            name, address, size = m.group(1), int(m.group(2), 16), int(m.group(3), 16)
+            inside = ram[0] <= address < ram[0] + ram[1]
+            current = name if inside and (name in STATIC or name in RESERVED) else None
+            if current:
+                sections[name] = (address, size)
+            continue
+        if not current or current in RESERVED:
+            continue
+
+        m = INPUT.match(line)
+        wrapped = INPUT_WRAPPED.match(line) if pending else None
+        if m or wrapped:
+            if m and m.group(2) is None:
+                pending = m.group(1)            # Long section name, numbers on the next line
+                continue
+            close_block()
+            address, size, obj = (m.group(2), m.group(3), m.group(4)) if m else wrapped.groups()
+            address, size = int(address, 16), int(size, 16)
+            pending = None
+            block = (address, size, object_name(obj), []) if size else None
+            if size:
+                objects[object_name(obj)] += size
+            continue
+        m = SYMBOL.match(line)
+        if m and block:
+            block[3].append((int(m.group(1), 16), m.group(2)))
+    close_block()
+    return ram, sections, objects, symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description='RAM budget from a GNU ld map file')
+    parser.add_argument('map')
+    parser.add_argument('--top', type=int, default=10, help='objects and symbols to list (10)')
+    parser.add_argument('--min-free', type=int, default=None, help='fail when fewer bytes are left')
+    parser.add_argument('--out', default=None, help='write the report to this file as well')
+    args = parser.parse_args()
+
+    with open(args.map, errors='replace') as f:
+        ram, sections, objects, symbols = parse(f)
+    if ram is None:
+        sys.exit('%s: no ram region in the memory configuration' % args.map)
+
+    used_static = sum(sections[s][1] for s in STATIC if s in sections)
+    reserved = sum(sections[s][1] for s in RESERVED if s in sections)
+    free = ram[1] - used_static - reserved
+
+    lines = []
+
+    def out(line):
+        print(line)
+        lines.append(line)
+
+    out('%s: ram 0x%08x, %d bytes' % (args.map, ram[0], ram[1]))
+    for name, (address, size) in sections.items():
+        out('  %-12s 0x%08x %7d' % (name, address, size))
+    out('  %-23s %7d  static' % ('', used_static))
+    out('  %-23s %7d  heap and stack reserved' % ('', reserved))
+    out('  %-23s %7d  free (%.1f%%)' % ('', free, 100.0 * free / ram[1]))
+
+    out('largest objects')
+    for obj, size in objects.most_common(args.top):
+        out('  %7d  %s' % (size, obj))
+    out('largest symbols')
+    for size, name, obj in sorted(symbols, reverse=True)[:args.top]:
+        out('  %7d  %s (%s)' % (size, name, obj))
+
+    out('ram static=%d reserved=%d free=%d total=%d' % (used_static, reserved, free, ram[1]))
+    over = args.min_free is not None and free < args.min_free
+    if over:
+        out('%d bytes free, under the %d byte budget' % (free, args.min_free))
+    if args.out:
+        with open(args.out, 'w') as f:
+            f.write('\n'.join(lines) + '\n')
+    return 1 if over else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
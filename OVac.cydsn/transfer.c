@@ -0,0 +1,226 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <project.h>
+#include <string.h>
+#include "transfer.h"
+#include "protocol.h"
+#include "fmt.h"
+
+/* Largest encoded chunk frame: header, offset, data, chunk crc, frame crc, COBS code and delimiter */
+#define CHUNK_PAYLOAD_LEN   (PROTO_CHUNK_HDR_LEN + TRANSFER_CHUNK_LEN + 2u)
+#define CHUNK_FRAME_MAX     (PROTO_HEADER_LEN + CHUNK_PAYLOAD_LEN + PROTO_CRC_LEN + \
+                             PROTO_COBS_OVERHEAD(CHUNK_PAYLOAD_LEN) + 1u)
+
+static const TRANSFER_IO *tio = 0;
+
+/* Written by the RX interrupt through Transfer_Request/Ack/Cancel */
+static volatile uint8_t req_pending = 0, cancel_pending = 0;
+static volatile uint16_t req_run = 0;
+static volatile uint32_t req_offset = 0;
+static volatile uint32_t acked = 0;         // Cumulative ack from the host
+
+/* Owned by Transfer_Poll, read by Transfer_Ack in the RX interrupt */
+static volatile uint8_t state = TRANSFER_IDLE;
+static volatile uint32_t high_sent = 0;     // Highest offset sent so far, to count resends and bound acks
+
+/* Owned by Transfer_Poll */
+static uint32_t size = 0;                   // Size of the open run
+static uint32_t next_send = 0;              // Offset of the next chunk to send
+static uint32_t last_acked = 0;
+static uint32_t last_progress = 0;          // Time of the last ack that moved the window
+static uint8_t retries = 0;
+
+TRANSFER_STATS transfer_stats;
+
+void Transfer_Init(const TRANSFER_IO *io){
+    tio = io;
+    state = TRANSFER_IDLE;
+    req_pending = 0;
+    cancel_pending = 0;
+    memset(&transfer_stats, 0, sizeof(transfer_stats));
+}
+
+/* Start (or resume) a download. Called from the command handler, the file is opened by Transfer_Poll. */
+void Transfer_Request(uint16_t run, uint32_t offset){
+    req_run = run;
+    req_offset = offset;
+    req_pending = 1;
+}
+
+/* An ack past the last byte sent cannot be for this transfer (a stale or corrupt frame), so it is dropped
+ * rather than letting the window skip data the host never got */
+void Transfer_Ack(uint32_t next){
+    if (state != TRANSFER_SENDING || next <= acked) return;
+    if (next > high_sent){
+        transfer_stats.acks_rejected++;
+        return;
+    }
+    acked = next;
+}
+
+void Transfer_Cancel(void){
+    cancel_pending = 1;
+}
+
+uint8_t Transfer_State(void){
+    return state;
+}
+
+static void finish(uint8_t result){
+    tio->close();
+    state = result;
+}
+
+static void start(uint32_t now_ms){
+    int32_t sz;
+    uint32_t offset;
+    uint16_t run;
+    uint8_t nak[2];
+    uint8 intState;
+
+    intState = CyEnterCriticalSection();
+    run = req_run;
+    offset = req_offset;
+    req_pending = 0;
+    CyExitCriticalSection(intState);
+
+    if (state == TRANSFER_SENDING) tio->close();
+
+    sz = tio->open(run);
+    if (sz < 0){
+        nak[0] = CMD_DATA;
+        nak[1] = NAK_VALUE;
+        tio->send(RSP_NAK, nak, sizeof(nak));
+        state = TRANSFER_FAILED;
+        return;
+    }
+    size = (uint32_t)sz;
+    if (offset > size) offset = size;
+
+    intState = CyEnterCriticalSection();      // Transfer_Ack sees the old transfer or the new one, not a mix
+    acked = offset;
+    last_acked = offset;
+    next_send = offset;
+    high_sent = offset;
+    last_progress = now_ms;
+    retries = 0;
+    state = TRANSFER_SENDING;
+    CyExitCriticalSection(intState);
+}
+
+/* Send one chunk at next_send, returns 0 if it could not be read */
+static uint8_t send_chunk(void){
+    uint8_t payload[CHUNK_PAYLOAD_LEN];
+    uint16_t n, i, crc = 0xFFFFu;
+
+    n = (size - next_send > TRANSFER_CHUNK_LEN) ? TRANSFER_CHUNK_LEN : (uint16_t)(size - next_send);
+    Proto_PutU32(payload, next_send);
+    if (tio->read(next_send, &payload[PROTO_CHUNK_HDR_LEN], n) != n) return 0;
+    for (i = 0; i < n; i++) crc = Proto_Crc16(crc, payload[PROTO_CHUNK_HDR_LEN + i]);
+    Proto_PutU16(&payload[PROTO_CHUNK_HDR_LEN + n], crc);
+
+    tio->send(RSP_CHUNK, payload, (uint8_t)(PROTO_CHUNK_HDR_LEN + n + 2u));
+
+    transfer_stats.chunks_sent++;
+    if (next_send < high_sent) transfer_stats.chunks_resent++;
+    next_send += n;
+    if (next_send > high_sent) high_sent = next_send;
+    return 1;
+}
+
+/* Advance the transfer. Call from the main loop; only sends while the link can take a whole chunk, so the
+ * window is limited by link throughput rather than by waiting on each ack. */
+void Transfer_Poll(uint32_t now_ms){
+    uint32_t a;
+    uint8_t end[PROTO_DATA_END_LEN];
+
+    if (tio == 0) return;
+
+    if (cancel_pending){
+        cancel_pending = 0;
+        if (state == TRANSFER_SENDING) finish(TRANSFER_IDLE);
+        state = TRANSFER_IDLE;
+    }
+    if (req_pending) start(now_ms);
+    if (state != TRANSFER_SENDING) return;
+
+    a = acked;
+    if (a != last_acked){                   // Window moved
+        last_acked = a;
+        last_progress = now_ms;
+        retries = 0;
+        transfer_stats.bytes_acked = a;
+    }
+
+    if (a >= size){
+        Proto_PutU32(end, size);
+        tio->send(RSP_DATA_END, end, sizeof(end));
+        finish(TRANSFER_DONE);
+        return;
+    }
+
+    if ((uint32_t)(now_ms - last_progress) >= TRANSFER_TIMEOUT_MS){
+        transfer_stats.timeouts++;
+        if (++retries > TRANSFER_MAX_RETRIES){
+            finish(TRANSFER_FAILED);
+            return;
+        }
+        next_send = a;                      // Go back to the first unacked byte
+        last_progress = now_ms;
+    }
+    if (next_send < a) next_send = a;
+
+    while (next_send < size && next_send < a + (uint32_t)TRANSFER_WINDOW * TRANSFER_CHUNK_LEN){
+        if (tio->tx_free() < CHUNK_FRAME_MAX) break;
+        if (!send_chunk()){
+            finish(TRANSFER_FAILED);
+            return;
+        }
+    }
+}
+
+/* Log file name of a run into name, which holds RUN_FILE_NAME_LEN. Returns the length. Runs past
+ * TRANSFER_RUN_MAX are named as TRANSFER_RUN_MAX so the name stays 8.3. */
+uint16_t Transfer_RunName(char *name, uint16_t run){
+    FMT f;
+
+    if (run > TRANSFER_RUN_MAX) run = TRANSFER_RUN_MAX;
+    Fmt_Start(&f, name, RUN_FILE_NAME_LEN);
+    FMT_LIT(&f, "test");
+    Fmt_Uint(&f, run, 0, ' ');
+    FMT_LIT(&f, ".txt");
+    return Fmt_Len(&f);
+}
+
+/* Run number of a log file name, 0 if it is not one. Either case, FAT short names come back in upper case. */
+uint16_t Transfer_RunNumber(const char *name){
+    static const char prefix[] = "test", suffix[] = ".txt";
+    uint32_t run = 0;
+    uint8_t i;
+
+    for (i = 0; prefix[i]; i++, name++) if ((*name | 0x20) != prefix[i]) return 0;
+    if (*name < '0' || *name > '9') return 0;
+    while (*name >= '0' && *name <= '9'){
+        run = run * 10u + (uint32_t)(*name++ - '0');
+        if (run > TRANSFER_RUN_MAX) return 0;
+    }
+    for (i = 0; suffix[i]; i++, name++) if ((*name | 0x20) != suffix[i]) return 0;
+    return (*name == 0) ? (uint16_t)run : 0;
+}
+
+/* Run number to log the next run under, after the last one on the card. Once the card reaches
+ * TRANSFER_RUN_MAX the last run is reused rather than making a name FAT cannot hold without LFN. */
+uint16_t Transfer_NextRun(uint16_t run){
+    return (run < TRANSFER_RUN_MAX) ? (uint16_t)(run + 1u) : (uint16_t)TRANSFER_RUN_MAX;
+}
+
+/* [] END OF FILE */
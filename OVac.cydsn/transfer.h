@@ -0,0 +1,96 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stdint.h>
+
+#ifndef _TRANSFER_H_
+#define _TRANSFER_H_
+
+/* Bulk download of a logged run over the framed Bluetooth protocol.
+ *
+ * The host sends CMD_DATA {run, offset}. The device answers with RSP_CHUNK frames, each carrying the file
+ * offset, up to TRANSFER_CHUNK_LEN bytes and a CRC-16 of those bytes, keeping up to TRANSFER_WINDOW chunks
+ * unacknowledged. The host acknowledges cumulatively with CMD_DATA_ACK {next offset}. If no ack arrives for
+ * TRANSFER_TIMEOUT_MS the device goes back to the last acked offset and resends. When every byte is acked
+ * the device sends RSP_DATA_END {size}. After a dropped link the host resumes by sending CMD_DATA again with
+ * the offset it had reached.
+ *
+ * The engine only talks to storage and the link through TRANSFER_IO, so it can be driven on a host against a
+ * simulated serial port: sim/test_transfer.c runs it over a link that drops, corrupts and reorders frames. */
+
+#define TRANSFER_CHUNK_LEN      128u        // Data bytes per chunk
+#define TRANSFER_WINDOW         4u          // Chunks in flight before waiting for an ack
+#define TRANSFER_TIMEOUT_MS     1000u       // Resend from the last ack after this long without progress
+#define TRANSFER_MAX_RETRIES    8u          // Give up after this many timeouts in a row
+
+#define RUN_FILE_NAME_LEN       16u         // Transfer_RunName output, "test<run>.txt" with its terminator
+#define TRANSFER_RUN_MAX        9999u       // "test9999.txt" is the longest 8.3 name, emFile has no LFN
+
+/* Engine state */
+#define TRANSFER_IDLE           0u
+#define TRANSFER_SENDING        1u
+#define TRANSFER_DONE           2u
+#define TRANSFER_FAILED         3u
+
+/* Wire payloads */
+typedef struct PROTO_DATA_REQ{
+    uint16_t run;                           // Run number to download
+    uint32_t offset;                        // Byte offset to start (or resume) from
+}PROTO_DATA_REQ;
+#define PROTO_DATA_REQ_LEN      6u
+
+typedef struct PROTO_DATA_ACK{
+    uint32_t next;                          // Every byte before this offset has been received intact
+}PROTO_DATA_ACK;
+#define PROTO_DATA_ACK_LEN      4u
+
+#define PROTO_CHUNK_HDR_LEN     4u          // offset:u32, then data, then crc16 of data
+#define PROTO_DATA_END_LEN      4u          // size:u32
+
+/* Storage and link bindings */
+typedef struct TRANSFER_IO{
+    int32_t (*open)(uint16_t run);          // Open a run, returns its size in bytes or -1 if missing
+    uint16_t (*read)(uint32_t offset, uint8_t *buf, uint16_t len);  // Read from the open run
+    void (*close)(void);
+    uint8_t (*send)(uint8_t cmd, const void *payload, uint8_t len); // Queue a frame, 0 if it did not fit
+    uint16_t (*tx_free)(void);              // Bytes the link can take without dropping
+}TRANSFER_IO;
+
+typedef struct TRANSFER_STATS{
+    uint32_t chunks_sent;
+    uint32_t chunks_resent;
+    uint32_t timeouts;
+    uint32_t bytes_acked;
+    uint32_t acks_rejected;                 // Acks past the last byte sent
+}TRANSFER_STATS;
+
+extern TRANSFER_STATS transfer_stats;
+
+void Transfer_Init(const TRANSFER_IO *io);
+
+void Transfer_Request(uint16_t run, uint32_t offset);
+
+void Transfer_Ack(uint32_t next);
+
+void Transfer_Cancel(void);
+
+void Transfer_Poll(uint32_t now_ms);
+
+uint8_t Transfer_State(void);
+
+uint16_t Transfer_RunName(char *name, uint16_t run);
+
+uint16_t Transfer_RunNumber(const char *name);
+
+uint16_t Transfer_NextRun(uint16_t run);
+
+#endif /* _TRANSFER_H_ */
+/* [] END OF FILE */